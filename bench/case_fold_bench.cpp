@@ -0,0 +1,114 @@
+// Microbenchmark for case folding.
+// Compares CaseFolder (ASCII fast path, reusable buffers) with the previous
+// utf8proc_map-per-call implementation on ASCII, mixed-case and accented
+// tokens, and checks that both produce the same text.
+
+#include "case_fold.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utf8proc.h>
+
+using namespace nameanalyzer;
+
+namespace {
+
+// The implementation before the fast path: one malloc'd buffer per call
+std::string fold_with_utf8proc_map(std::string_view str) {
+    utf8proc_uint8_t* result = nullptr;
+    utf8proc_ssize_t result_size = utf8proc_map(
+        reinterpret_cast<const utf8proc_uint8_t*>(str.data()),
+        static_cast<utf8proc_ssize_t>(str.size()),
+        &result,
+        static_cast<utf8proc_option_t>(UTF8PROC_STABLE | UTF8PROC_COMPOSE | UTF8PROC_CASEFOLD)
+    );
+    if (result_size < 0 || !result) {
+        throw std::runtime_error("UTF-8 case conversion failed");
+    }
+    std::string output(reinterpret_cast<const char*>(result), static_cast<size_t>(result_size));
+    free(result);
+    return output;
+}
+
+std::vector<std::string> make_tokens(const std::vector<std::string>& alphabet, std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> letter(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> length(3, 12);
+
+    std::vector<std::string> tokens(count);
+    for (auto& token : tokens) {
+        int n = length(rng);
+        for (int i = 0; i < n; ++i) {
+            token += alphabet[letter(rng)];
+        }
+    }
+    return tokens;
+}
+
+template <typename Fold>
+double time_per_token(const std::vector<std::string>& tokens, Fold fold, std::size_t& checksum) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& token : tokens) {
+        checksum += fold(token);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(tokens.size());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    struct Corpus {
+        const char* name;
+        std::vector<std::string> alphabet;
+    };
+    const std::vector<Corpus> corpora = {
+        {"ascii-lower", {"a", "b", "c", "d", "e", "f", "g", "h", "i", "k", "l", "m", "n", "o", "r", "s", "t", "u"}},
+        {"ascii-mixed", {"a", "B", "c", "D", "e", "F", "g", "H", "i", "K", "l", "M", "n", "O", "r", "S", "t", "U"}},
+        {"accented", {"a", "b", "c", "d", "e", "\xC3\xA9", "\xC3\x89", "\xC3\xB8", "\xC3\x85", "n", "o", "r", "s",
+                      "\xC3\x9F", "t", "u"}},
+    };
+
+    std::cout << std::left << std::setw(14) << "corpus" << std::right
+              << std::setw(16) << "utf8proc ns/tok" << std::setw(16) << "folder ns/tok"
+              << std::setw(10) << "speedup" << "\n";
+
+    std::size_t total_bytes = 0;  // Keeps the folded results observable
+    for (const auto& corpus : corpora) {
+        auto tokens = make_tokens(corpus.alphabet, count, 42);
+
+        CaseFolder folder;
+        std::string folded;
+        for (const auto& token : tokens) {
+            folder.fold(token, folded);
+            if (folded != fold_with_utf8proc_map(token)) {
+                std::cerr << "Mismatch folding " << token << "\n";
+                return 1;
+            }
+        }
+
+        std::size_t checksum = 0;
+        double old_ns = time_per_token(tokens, [](const std::string& token) {
+            return fold_with_utf8proc_map(token).size();
+        }, checksum);
+        double new_ns = time_per_token(tokens, [&](const std::string& token) {
+            folder.fold(token, folded);
+            return folded.size();
+        }, checksum);
+
+        std::cout << std::left << std::setw(14) << corpus.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(16) << old_ns << std::setw(16) << new_ns
+                  << std::setw(9) << old_ns / new_ns << "x\n";
+        total_bytes += checksum;
+    }
+
+    std::cout << "(folded " << total_bytes << " bytes)\n";
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "corpus_generator.hpp"
+#include <iterator>
+#include <random>
+
+namespace nameanalyzer {
+
+namespace {
+
+const char* const ascii_onsets[] = {"", "b", "br", "ch", "d", "dr", "f", "g", "gr", "h", "k", "kr",
+                                    "l", "m", "n", "p", "pr", "r", "s", "sh", "st", "str", "t",
+                                    "th", "thr", "v", "w", "z"};
+const char* const ascii_nuclei[] = {"a", "e", "i", "o", "u", "y", "ae", "ai", "ea", "ei", "ou", "io"};
+const char* const ascii_codas[] = {"", "", "", "l", "m", "n", "r", "s", "t", "nd", "ng", "rk", "st"};
+
+const char* const accented_nuclei[] = {"\xC3\xA1", "\xC3\xA9", "\xC3\xAD", "\xC3\xB3", "\xC3\xBA",  // á é í ó ú
+                                       "\xC3\xA0", "\xC3\xA8", "\xC3\xB6", "\xC3\xBC", "\xC3\xA5",  // à è ö ü å
+                                       "\xC3\xB8", "\xC3\xA6"};                                      // ø æ
+const char* const accented_consonants[] = {"\xC3\xB1", "\xC3\xA7", "\xC3\x9F", "\xC5\xA1", "\xC5\xBE"};  // ñ ç ß š ž
+const char* const accented_capitals[] = {"\xC3\x81", "\xC3\x89", "\xC3\x96", "\xC3\x85", "\xC3\x98"};  // Á É Ö Å Ø
+
+const char* const cyrillic_onsets[] = {"", "\xD0\xB1", "\xD0\xB2", "\xD0\xB3", "\xD0\xB4", "\xD0\xB6",   // б в г д ж
+                                       "\xD0\xB7", "\xD0\xBA", "\xD0\xBB", "\xD0\xBC", "\xD0\xBD",       // з к л м н
+                                       "\xD0\xBF", "\xD1\x80", "\xD1\x81", "\xD1\x82", "\xD1\x85",       // п р с т х
+                                       "\xD1\x87", "\xD1\x88", "\xD1\x81\xD1\x82", "\xD0\xB2\xD0\xBB"};  // ч ш ст вл
+const char* const cyrillic_nuclei[] = {"\xD0\xB0", "\xD0\xB5", "\xD0\xB8", "\xD0\xBE", "\xD1\x83",       // а е и о у
+                                       "\xD1\x8B", "\xD1\x8F", "\xD1\x8E", "\xD1\x91"};                  // ы я ю ё
+const char* const cyrillic_codas[] = {"", "", "", "\xD0\xB9", "\xD0\xBD", "\xD1\x80", "\xD0\xB2",        // й н р в
+                                      "\xD0\xBB", "\xD1\x81\xD0\xBA"};                                   // л ск
+const char* const cjk_ideographs[] = {"\xE7\x8E\x8B", "\xE6\x9D\x8E", "\xE5\xBC\xA0", "\xE5\x88\x98",    // 王 李 张 刘
+                                      "\xE9\x99\x88", "\xE6\x98\x8E", "\xE5\x8D\x8E", "\xE4\xBC\x9F",    // 陈 明 华 伟
+                                      "\xE8\x8A\xB3", "\xE5\xA8\x9C", "\xE6\x95\x8F", "\xE9\x9D\x99",    // 芳 娜 敏 静
+                                      "\xE4\xB8\xBD", "\xE5\xBC\xBA", "\xE7\xA3\x8A", "\xE5\x86\x9B",    // 丽 强 磊 军
+                                      "\xE6\xB4\x8B", "\xE5\x8B\x87", "\xE8\x89\xB3", "\xE6\x9D\xB0",    // 洋 勇 艳 杰
+                                      "\xE5\xA8\x9F", "\xE6\xB6\x9B", "\xE6\x98\x8E", "\xE8\xB6\x85"};   // 娟 涛 明 超
+
+/// Seeded generator whose output does not depend on the standard library:
+/// std::mt19937 is fully specified, the standard distributions are not
+class Picker {
+public:
+    explicit Picker(std::uint32_t seed) : rng_(seed) {}
+
+    std::size_t below(std::size_t n) { return static_cast<std::size_t>(rng_() % n); }
+    bool chance(unsigned percent) { return below(100) < percent; }
+
+    template <typename Table>
+    const char* pick(const Table& table) { return table[below(std::size(table))]; }
+
+private:
+    std::mt19937 rng_;
+};
+
+std::string ascii_name(Picker& picker) {
+    std::string word;
+    std::size_t syllables = 1 + picker.below(4);
+    for (std::size_t s = 0; s < syllables; ++s) {
+        word += picker.pick(ascii_onsets);
+        word += picker.pick(ascii_nuclei);
+        word += picker.pick(ascii_codas);
+    }
+    return word;
+}
+
+std::string accented_name(Picker& picker) {
+    std::string word;
+    if (picker.chance(20)) {
+        word += picker.pick(accented_capitals);
+    } else if (picker.chance(50)) {
+        // Capitalized ASCII onset, folded to lowercase on input
+        std::string_view onset;
+        while (onset.empty()) {
+            onset = picker.pick(ascii_onsets);
+        }
+        word += static_cast<char>(onset[0] - 'a' + 'A');
+        word += onset.substr(1);
+    }
+    std::size_t syllables = 1 + picker.below(4);
+    for (std::size_t s = 0; s < syllables; ++s) {
+        word += picker.chance(15) ? picker.pick(accented_consonants) : picker.pick(ascii_onsets);
+        word += picker.chance(35) ? picker.pick(accented_nuclei) : picker.pick(ascii_nuclei);
+        word += picker.pick(ascii_codas);
+    }
+    return word;
+}
+
+std::string cyrillic_name(Picker& picker) {
+    std::string word;
+    std::size_t syllables = 1 + picker.below(4);
+    for (std::size_t s = 0; s < syllables; ++s) {
+        word += picker.pick(cyrillic_onsets);
+        word += picker.pick(cyrillic_nuclei);
+        word += picker.pick(cyrillic_codas);
+    }
+    return word;
+}
+
+std::string cjk_name(Picker& picker) {
+    std::string word;
+    std::size_t length = 2 + picker.below(2);
+    for (std::size_t i = 0; i < length; ++i) {
+        word += picker.pick(cjk_ideographs);
+    }
+    return word;
+}
+
+} // namespace
+
+std::string_view corpus_script_name(CorpusScript script) {
+    switch (script) {
+        case CorpusScript::Ascii: return "ascii";
+        case CorpusScript::Accented: return "accented";
+        case CorpusScript::CjkCyrillic: return "cjk-cyrillic";
+    }
+    return "unknown";
+}
+
+std::optional<CorpusScript> parse_corpus_script(std::string_view name) {
+    for (CorpusScript script : {CorpusScript::Ascii, CorpusScript::Accented, CorpusScript::CjkCyrillic}) {
+        if (name == corpus_script_name(script)) {
+            return script;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string> generate_corpus(CorpusScript script, std::size_t count, std::uint32_t seed) {
+    Picker picker(seed);
+    std::vector<std::string> words;
+    words.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        switch (script) {
+            case CorpusScript::Ascii:
+                words.push_back(ascii_name(picker));
+                break;
+            case CorpusScript::Accented:
+                words.push_back(accented_name(picker));
+                break;
+            case CorpusScript::CjkCyrillic: {
+                std::size_t kind = picker.below(10);
+                words.push_back(kind < 5 ? cyrillic_name(picker) : kind < 8 ? cjk_name(picker) : ascii_name(picker));
+                break;
+            }
+        }
+    }
+    return words;
+}
+
+} // namespace nameanalyzer
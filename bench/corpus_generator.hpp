@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Writing systems the synthetic corpus generator can produce
+enum class CorpusScript {
+    Ascii,       // lowercase English-like names
+    Accented,    // Latin names with diacritics and capitalized first letters
+    CjkCyrillic  // Cyrillic names mixed with CJK ideograph names and some ASCII
+};
+
+std::string_view corpus_script_name(CorpusScript script);
+std::optional<CorpusScript> parse_corpus_script(std::string_view name);
+
+/// Generate count pronounceable names built from random onset, nucleus and
+/// coda pieces, so the number of distinct n-grams and syllables keeps growing
+/// with the corpus as it does in real name lists. The same seed gives the
+/// same corpus on every platform.
+std::vector<std::string> generate_corpus(CorpusScript script, std::size_t count, std::uint32_t seed);
+
+} // namespace nameanalyzer
@@ -0,0 +1,259 @@
+// Benchmark suite for the analysis pipeline.
+// Generates seeded synthetic corpora for each script at sizes from
+// --min-words to --max-words (powers of ten), times every stage on them and
+// prints one tab-separated row per stage, so runs from two commits can be
+// compared with diff or loaded into a spreadsheet.
+//
+// Columns: script, words, stage, seconds, words_per_s, bytes, mb_per_s,
+// peak_rss_kb. bytes is the stage's input (the corpus file, or the UTF-8
+// text of the words), except for write_json where it is the output size.
+// peak_rss_kb is the high-water mark of resident memory during the stage,
+// where the platform can reset it (Linux), and of the whole process otherwise.
+
+#include "corpus_generator.hpp"
+#include "corpus_analyzer.hpp"
+#include "json_writer.hpp"
+#include "markov_builder.hpp"
+#include "ngram_extractor.hpp"
+#include "stage_profiler.hpp"
+#include "syllable_detector.hpp"
+#include "word_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace nameanalyzer;
+
+namespace {
+
+struct Options {
+    std::size_t min_words = 1000;
+    std::size_t max_words = 100000;
+    std::vector<CorpusScript> scripts = {CorpusScript::Ascii, CorpusScript::Accented,
+                                         CorpusScript::CjkCyrillic};
+    std::uint32_t seed = 42;
+    int markov_order = 3;
+    std::string write_corpus;  // Only generate a corpus file, of max_words words
+};
+
+void print_usage(std::string_view program_name) {
+    std::cout << "Usage: " << program_name << " [options]\n\n"
+              << "Options:\n"
+              << "  --min-words <n>         Smallest corpus (default: 1000)\n"
+              << "  --max-words <n>         Largest corpus; sizes go up in powers of ten (default: 100000)\n"
+              << "  --scripts <list>        Comma-separated: ascii, accented, cjk-cyrillic (default: all)\n"
+              << "  --seed <n>              Corpus generator seed (default: 42)\n"
+              << "  --markov-order <n>      Markov order for the letter and pipeline stages (default: 3)\n"
+              << "  --write-corpus <file>   Write one generated corpus of --max-words words and exit\n"
+              << "  -h, --help              Show this help message\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires an argument\n";
+            return false;
+        }
+        std::string_view value = argv[++i];
+        if (arg == "--min-words") {
+            options.min_words = std::strtoull(value.data(), nullptr, 10);
+        } else if (arg == "--max-words") {
+            options.max_words = std::strtoull(value.data(), nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<std::uint32_t>(std::strtoul(value.data(), nullptr, 10));
+        } else if (arg == "--markov-order") {
+            options.markov_order = std::atoi(value.data());
+        } else if (arg == "--write-corpus") {
+            options.write_corpus = value;
+        } else if (arg == "--scripts") {
+            options.scripts.clear();
+            while (!value.empty()) {
+                std::size_t comma = value.find(',');
+                std::string_view name = value.substr(0, comma);
+                auto script = parse_corpus_script(name);
+                if (!script) {
+                    std::cerr << "Error: Unknown script: " << name << "\n";
+                    return false;
+                }
+                options.scripts.push_back(*script);
+                value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+            }
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    bool sizes_valid = options.min_words >= 1 && options.max_words >= 1 &&
+                       (options.max_words >= options.min_words || !options.write_corpus.empty());
+    if (!sizes_valid || options.markov_order < 1 || options.scripts.empty()) {
+        std::cerr << "Error: Invalid options\n";
+        return false;
+    }
+    return true;
+}
+
+// Start a new peak-RSS measurement; false if only the process-wide peak is available
+bool start_rss_measurement() {
+#if defined(__GLIBC__)
+    // Hand memory freed by earlier stages back to the system first, or it
+    // would count towards this stage's peak
+    malloc_trim(0);
+#endif
+    return reset_peak_rss();
+}
+
+void print_header() {
+    std::cout << "script\twords\tstage\tseconds\twords_per_s\tbytes\tmb_per_s\tpeak_rss_kb\n";
+}
+
+/// Time one stage; stage() returns the number of bytes it processed
+template <typename Stage>
+void run_stage(CorpusScript script, std::size_t words, std::string_view name, Stage stage) {
+    start_rss_measurement();
+    auto start = std::chrono::steady_clock::now();
+    std::size_t bytes = stage();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long rss = peak_rss_kb().value_or(0);
+
+    std::cout << corpus_script_name(script) << '\t' << words << '\t' << name << '\t'
+              << std::fixed << std::setprecision(6) << seconds << '\t'
+              << std::setprecision(0) << static_cast<double>(words) / seconds << '\t'
+              << bytes << '\t'
+              << std::setprecision(2) << static_cast<double>(bytes) / seconds / 1e6 << '\t'
+              << rss << '\n' << std::flush;
+}
+
+std::size_t write_corpus_file(const std::vector<std::string>& words, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    std::size_t bytes = 0;
+    for (const auto& word : words) {
+        out << word << '\n';
+        bytes += word.size() + 1;
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+    return bytes;
+}
+
+void bench_corpus(CorpusScript script, std::size_t count, const Options& options,
+                  const std::filesystem::path& scratch_dir) {
+    std::vector<std::string> corpus = generate_corpus(script, count, options.seed);
+    std::string corpus_path = (scratch_dir / "corpus.txt").string();
+    std::string json_path = (scratch_dir / "profile.json").string();
+    std::size_t file_bytes = write_corpus_file(corpus, corpus_path);
+
+    // Every stage but read works on the folded, filtered words, as in the CLI
+    std::vector<std::string> words;
+    run_stage(script, count, "read", [&] {
+        words = read_words(corpus_path);
+        return file_bytes;
+    });
+    run_stage(script, count, "read_parallel", [&] {
+        // Every core, in the CLI's batches; files under 1 MiB stay sequential
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        WordReader reader(corpus_path, 2, false, threads);
+        std::vector<std::string> batch;
+        while (reader.next_batch(batch, Config{}.batch_size)) {
+        }
+        return file_bytes;
+    });
+
+    std::size_t text_bytes = 0;
+    for (const auto& word : words) {
+        text_bytes += word.size();
+    }
+
+    std::size_t sink = 0;  // Keeps stage results observable
+    run_stage(script, count, "letters", [&] {
+        StringPool strings;
+        LetterAnalysis letters = analyze_letters(words, options.markov_order, strings);
+        sink += letters.fourgrams.size();
+        return text_bytes;
+    });
+    run_stage(script, count, "markov", [&] {
+        StringPool strings;
+        MarkovChain chain = build_markov_chain(words, options.markov_order, strings);
+        sink += chain.size();
+        return text_bytes;
+    });
+    run_stage(script, count, "syllables", [&] {
+        for (const auto& word : words) {
+            sink += detect_syllables(word).size();
+        }
+        return text_bytes;
+    });
+
+    Config config;
+    config.input_file = corpus_path;
+    config.markov_order = options.markov_order;
+    AnalysisResults results;
+    run_stage(script, count, "pipeline", [&] {
+        results = analyze_corpus(words, config);
+        return text_bytes;
+    });
+    run_stage(script, count, "write_json", [&] {
+        write_json_output(results, json_path);
+        return static_cast<std::size_t>(std::filesystem::file_size(json_path));
+    });
+
+    if (sink == 0) {
+        std::cerr << "(empty results)\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    try {
+        if (!options.write_corpus.empty()) {
+            auto words = generate_corpus(options.scripts.front(), options.max_words, options.seed);
+            write_corpus_file(words, options.write_corpus);
+            return 0;
+        }
+
+        auto scratch_dir = std::filesystem::temp_directory_path() /
+                           ("nameanalyzer_bench_" + std::to_string(
+                               std::chrono::steady_clock::now().time_since_epoch().count()));
+        std::filesystem::create_directories(scratch_dir);
+
+        std::cout << "# nameanalyzer_bench seed=" << options.seed
+                  << " markov_order=" << options.markov_order
+                  << " peak_rss=" << (start_rss_measurement() ? "per-stage" : "process") << "\n";
+        print_header();
+        for (CorpusScript script : options.scripts) {
+            for (std::size_t count = options.min_words; count <= options.max_words; count *= 10) {
+                bench_corpus(script, count, options, scratch_dir);
+            }
+        }
+
+        std::filesystem::remove_all(scratch_dir);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Scaling benchmark for analyze_syllables.
+// Times the syllable step over seeded synthetic corpora of growing size and
+// prints ns/word for each; a flat ns/word column means linear scaling.
+
+#include "syllable_detector.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nameanalyzer;
+
+namespace {
+
+// Build pronounceable-ish words from random onset/vowel/coda pieces so the
+// unique-syllable count keeps growing with the corpus, as in real name lists
+std::vector<std::string> make_corpus(std::size_t count, unsigned seed) {
+    static const char* onsets[] = {"", "b", "br", "ch", "d", "dr", "f", "g", "gr", "h", "k", "kr",
+                                   "l", "m", "n", "p", "pr", "r", "s", "sh", "st", "str", "t",
+                                   "th", "thr", "v", "w", "z"};
+    static const char* nuclei[] = {"a", "e", "i", "o", "u", "y", "ae", "ai", "ea", "ei", "ou", "io"};
+    static const char* codas[] = {"", "", "", "l", "m", "n", "r", "s", "t", "nd", "ng", "rk", "st"};
+
+    std::mt19937 rng(seed);
+    auto pick = [&rng](const auto& table) {
+        std::uniform_int_distribution<std::size_t> dist(0, std::size(table) - 1);
+        return table[dist(rng)];
+    };
+    std::uniform_int_distribution<int> syllable_count(1, 4);
+
+    std::vector<std::string> words;
+    words.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string word;
+        int n = syllable_count(rng);
+        for (int s = 0; s < n; ++s) {
+            word += pick(onsets);
+            word += pick(nuclei);
+            word += pick(codas);
+        }
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t max_words = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    int markov_order = argc > 2 ? std::atoi(argv[2]) : 2;
+
+    std::cout << std::setw(10) << "words" << std::setw(12) << "unique"
+              << std::setw(12) << "seconds" << std::setw(12) << "ns/word" << "\n";
+
+    for (std::size_t count = 1000; count <= max_words; count *= 4) {
+        auto words = make_corpus(count, 42);
+
+        auto start = std::chrono::steady_clock::now();
+        StringPool strings;
+        SyllableAnalysis analysis = analyze_syllables(words, markov_order, strings);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << std::setw(10) << count
+                  << std::setw(12) << analysis.all_syllables.size()
+                  << std::setw(12) << std::fixed << std::setprecision(4) << seconds
+                  << std::setw(12) << std::setprecision(1) << seconds * 1e9 / static_cast<double>(count)
+                  << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Walker alias table: draws outcome i with probability weight[i] / total in
+/// constant time, whatever the number of outcomes.
+///
+/// To sample, pick a column i uniformly, then keep i if a uniform value in
+/// [0, 1) is below thresholds()[i] and take aliases()[i] otherwise.
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    /// Build the table for the given weights (Vose's method, O(n)).
+    /// Throws std::invalid_argument if the weights are empty or all zero.
+    explicit AliasTable(const std::vector<std::size_t>& weights);
+
+    /// Outcome for a uniform column draw in [0, size()) and a uniform
+    /// value in [0, 1)
+    std::size_t sample(std::size_t column, double coin) const {
+        return coin < thresholds_[column] ? column : aliases_[column];
+    }
+
+    /// Outcome for a single uniform value in [0, 1), split into the column
+    /// and the coin
+    std::size_t sample(double uniform) const;
+
+    std::size_t size() const { return thresholds_.size(); }
+
+    /// Normalized probability of each outcome
+    const std::vector<double>& probabilities() const { return probabilities_; }
+    const std::vector<double>& thresholds() const { return thresholds_; }
+    const std::vector<std::uint32_t>& aliases() const { return aliases_; }
+
+private:
+    std::vector<double> probabilities_;
+    std::vector<double> thresholds_;
+    std::vector<std::uint32_t> aliases_;
+};
+
+} // namespace nameanalyzer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "string_table.hpp"
+#include "utf8_word.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Compact integer codes for the distinct characters of a corpus.
+/// A character is the UTF-8 text of one decoded codepoint; codes are handed
+/// out densely in first-seen order, with a direct table for ASCII. The
+/// symbols are interned in a small pool of the alphabet's own.
+class Alphabet {
+public:
+    /// Codes must fit in 16 bits so four of them pack into one 64-bit key
+    static constexpr std::uint32_t max_size = 0xFFFF;
+
+    Alphabet();
+
+    /// Code of symbol, assigning the next free code if it is new.
+    /// Throws std::runtime_error once more than max_size symbols are seen.
+    std::uint32_t encode(std::string_view symbol);
+
+    /// Codes of every character of word, in order
+    void encode_word(const Utf8Word& word, std::vector<std::uint32_t>& codes);
+
+    const InternedString& symbol(std::uint32_t code) const { return symbols_[code]; }
+
+    /// Hash of the symbol's text, the same in every alphabet that has it
+    std::uint64_t symbol_hash(std::uint32_t code) const { return hashes_[code]; }
+    std::size_t size() const { return symbols_.size(); }
+
+    /// Every symbol, indexed by code
+    const StringTable& symbols() const { return symbols_; }
+
+private:
+    static constexpr std::uint32_t unassigned = ~0u;
+
+    std::array<std::uint32_t, 128> ascii_codes_;
+    std::shared_ptr<StringPool> strings_;  // Shared by copies, like the symbols
+    StringTable symbols_;
+    std::vector<std::uint64_t> hashes_;  // Indexed by code
+};
+
+} // namespace nameanalyzer
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace nameanalyzer {
+
+// Count merging for analysis shards. Every count is a plain sum, so merging
+// is commutative; src is consumed (its nodes are spliced into dst where possible).
+// Under lossy counting, keys that dst lacks start from dst's floor (see
+// add_count) before src's count is added. Keys move from src to dst as they
+// are, still interned in src's pool, so whoever owns dst must keep that
+// pool too (see keep_strings).
+
+void merge_frequencies(FrequencyMap& dst, FrequencyMap&& src, std::size_t floor = 0);
+void merge_positional(PositionalFrequencies& dst, PositionalFrequencies&& src, std::size_t floor = 0);
+void merge_markov_chain(MarkovChain& dst, MarkovChain&& src);
+void merge_markov_chains(std::map<int, MarkovChain>& dst, std::map<int, MarkovChain>&& src);
+
+void merge_letter_analysis(LetterAnalysis& dst, LetterAnalysis&& src);
+void merge_component_analysis(ComponentAnalysis& dst, ComponentAnalysis&& src, std::size_t floor = 0);
+
+/// Merge raw counts only; averages must be recomputed afterwards
+void merge_stats(CorpusStats& dst, const CorpusStats& src);
+
+/// Recompute the averages from the raw counts
+void update_derived_stats(CorpusStats& stats);
+
+/// Merge syllable counts and append src's unseen syllables to
+/// dst.all_syllables in src's order
+void merge_syllable_analysis(SyllableAnalysis& dst, SyllableAnalysis&& src, std::size_t floor = 0);
+
+/// Make dst hold on to the pools of src's keys, unless they are its own
+void keep_strings(AnalysisResults& dst, const AnalysisResults& src);
+
+/// Merge every section of finished results src into dst and recompute the
+/// averages. dst keeps its config, and src's pools (keep_strings).
+void merge_results(AnalysisResults& dst, AnalysisResults&& src);
+
+} // namespace nameanalyzer
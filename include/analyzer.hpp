@@ -0,0 +1,115 @@
+#pragma once
+
+#include "types.hpp"
+#include "corpus_analyzer.hpp"
+#include "word_reader.hpp"
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Make config's pruning and approximation at least as strong as other's:
+/// the larger min_count, approximate_epsilon and prune_epsilon, and the
+/// smaller top_k_per_context where either is set. Counts that were pruned
+/// or approximated once stay so when profiles are combined.
+void keep_strongest_pruning(Config& config, const Config& other);
+
+/// Settings for adding words to a profile built with `profile`: config,
+/// with the profile's Markov order, minimum word length, sections and
+/// phonemes, the strongest pruning of the two (keep_strongest_pruning),
+/// sampling tables if either has them, and the profile's input_file
+/// followed by config's, comma-separated. Analyzer and --update both use
+/// it, so a continued profile is labelled the same either way.
+Config continued_config(const Config& profile, Config config);
+
+/// In-memory analysis, for programs that profile word lists without going
+/// through files:
+///
+///     nameanalyzer::Analyzer analyzer(config);
+///     analyzer.add(names);                  // any range of strings
+///     analyzer.add("Æsir");                 // or one word at a time
+///     AnalysisResults profile = analyzer.finish();
+///
+/// Words are case-folded and filtered exactly as when read from a file, so
+/// the results equal those of the command-line tool on the same words.
+/// config.input_file and config.output_file are not used. With
+/// config.threads > 1, words are buffered and analyzed config.batch_size at
+/// a time; the results do not depend on the thread count. An Analyzer is
+/// not safe to share between threads; use one per thread and combine the
+/// results with merge_results().
+class Analyzer {
+public:
+    /// Throws std::runtime_error if config asks for a Markov order above
+    /// max_markov_order or an approximation error below
+    /// min_approximate_epsilon.
+    explicit Analyzer(const Config& config = Config{});
+
+    /// Continue an existing profile, such as one returned by finish() or
+    /// read_json_profile(), with continued_config(profile.config, config):
+    /// the words are analyzed with the profile's settings, and pruning and
+    /// approximation are never weaker than the profile's.
+    Analyzer(AnalysisResults profile, const Config& config);
+
+    /// Settings the words are analyzed with, which finish() records
+    const Config& config() const { return config_; }
+
+    /// Add one word. Returns false if it was rejected as too short or for
+    /// containing punctuation. Throws std::runtime_error on invalid UTF-8.
+    bool add(std::string_view word);
+
+    /// Add one word as weight occurrences of it, as from a frequency list.
+    /// A weight of 0 adds nothing and returns false.
+    bool add(std::string_view word, std::size_t weight);
+
+    /// Add words in order; returns how many were accepted
+    std::size_t add(std::span<const std::string> words);
+    std::size_t add(std::span<const std::string_view> words);
+
+    template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+    std::size_t add(Iterator first, Sentinel last) {
+        std::size_t accepted = 0;
+        for (; first != last; ++first) {
+            accepted += add(std::string_view(*first));
+        }
+        return accepted;
+    }
+
+    /// Add words that were already folded and filtered, such as the
+    /// batches of a WordReader, with a weight per word or once each if
+    /// weights is empty
+    void add_prepared(std::span<const std::string> words, std::span<const std::size_t> weights = {});
+
+    /// Words accepted so far, each weighted word counting once, not
+    /// counting those of a continued profile
+    std::size_t words_added() const { return words_added_; }
+
+    /// Results for the words added so far; the analyzer can keep going.
+    /// Copies the accumulated counts, so prefer finish() for the last call.
+    AnalysisResults results() const;
+
+    /// Results for the words added so far. The analyzer is then reset to
+    /// an empty profile with the same settings.
+    AnalysisResults finish();
+
+    /// Wall time and allocations of the parts of the analysis pass; empty
+    /// unless config.profile_stages is set
+    const std::vector<StageTiming>& stage_timings() const { return analyzer_.stage_timings(); }
+
+private:
+    void flush();
+
+    Config config_;
+    CorpusAnalyzer analyzer_;
+    WordFilter filter_;
+    std::vector<std::string> pending_;        // Words waiting for a threaded batch
+    std::vector<std::size_t> pending_weights_;
+    std::optional<AnalysisResults> profile_;  // Profile being continued
+    std::size_t words_added_ = 0;
+};
+
+} // namespace nameanalyzer
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Smallest epsilon accepted for approximate counting. The sketch width
+/// grows as 1 / epsilon; at this bound a sketch takes about 20 MB.
+constexpr double min_approximate_epsilon = 1e-5;
+
+/// Count-min sketch with conservative update. Estimates never fall below
+/// the true count and, with probability 1 - delta, exceed it by at most
+/// epsilon times the total of all counts. Memory is fixed by epsilon and
+/// delta, however many distinct keys are added.
+class CountMinSketch {
+public:
+    CountMinSketch(double epsilon, double delta);
+
+    /// Add count to key and return the new estimate of key
+    std::size_t add(std::uint64_t key, std::size_t count = 1);
+
+    std::size_t estimate(std::uint64_t key) const;
+
+    /// Zero every counter, keeping the memory
+    void clear();
+
+    /// Add other's counters; both sketches must have been built with the
+    /// same epsilon and delta
+    void merge(const CountMinSketch& other);
+
+    std::size_t width() const { return width_; }
+    std::size_t depth() const { return depth_; }
+
+private:
+    std::size_t cell(std::size_t row, std::uint64_t key) const;
+
+    std::size_t width_;  // Power of two
+    std::size_t depth_;
+    int shift_;          // 64 - log2(width_)
+    std::vector<std::size_t> counters_;  // depth_ rows of width_ counters
+};
+
+/// Approximate counts for a key space too large to count exactly: a
+/// count-min sketch sees every occurrence, and a fixed-size list keeps the
+/// keys with the highest estimates. Rare keys fall out of the list, which is
+/// where the error goes.
+///
+/// Every key is identified twice: by `hash`, which must not depend on the
+/// shard that counted it and feeds the sketch, and by `item`, a packed
+/// value to spell the key out with (such as alphabet codes) that merge()
+/// can translate between shards.
+class ApproximateCounter {
+public:
+    /// The list holds 2 / epsilon keys, enough for every key whose count
+    /// exceeds epsilon times the total
+    ApproximateCounter(double epsilon, double delta);
+
+    /// Add count occurrences of the key hash identifies
+    void add(std::uint64_t hash, std::uint64_t item, std::size_t count = 1);
+
+    /// Add src's counts. remap_item translates one of src's items into this
+    /// counter's terms.
+    template <typename Remap>
+    void merge(const ApproximateCounter& src, Remap&& remap_item) {
+        sketch_.merge(src.sketch_);
+        std::vector<Entry> candidates = heap_;
+        for (const Entry& entry : src.heap_) {
+            candidates.push_back({0, entry.hash, remap_item(entry.item)});
+        }
+        rebuild(std::move(candidates));
+    }
+
+    /// Call f(item, estimated count) for every kept key, in no particular order
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const Entry& entry : heap_) {
+            f(entry.item, entry.count);
+        }
+    }
+
+    /// Forget every count, keeping the sketch's memory for reuse
+    void clear();
+
+    std::size_t size() const { return heap_.size(); }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        std::size_t count;
+        std::uint64_t hash;
+        std::uint64_t item;
+    };
+
+    // Min-heap order; the hash breaks ties so eviction does not depend on
+    // insertion order
+    static bool lower(const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count < b.count : a.hash < b.hash;
+    }
+
+    void sift_up(std::size_t pos);
+    void sift_down(std::size_t pos);
+    void place(std::size_t pos, const Entry& entry);
+
+    /// Re-estimate candidates (deduplicated by hash) and keep the best
+    void rebuild(std::vector<Entry> candidates);
+
+    CountMinSketch sketch_;
+    std::size_t capacity_;
+    std::vector<Entry> heap_;                              // Kept keys
+    std::unordered_map<std::uint64_t, std::size_t> slots_;  // hash -> heap_ index
+};
+
+/// Mix a symbol hash into a running key hash
+inline std::uint64_t combine_hash(std::uint64_t seed, std::uint64_t hash) {
+    std::uint64_t x = (seed ^ hash) * 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 29);
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// True if every byte of str is 7-bit ASCII (SIMD-checked where available)
+bool is_ascii(std::string_view str);
+
+/// Unicode case folding (utf8proc CASEFOLD with NFC composition) that
+/// reuses its buffers, so folding a stream of strings does not allocate
+/// once the buffers have grown to fit. ASCII input skips utf8proc entirely.
+class CaseFolder {
+public:
+    /// Fold str into out, reusing out's storage.
+    /// Stops at the first NUL byte, like utf8proc's NUL-terminated mode.
+    /// Throws std::runtime_error on invalid UTF-8.
+    void fold(std::string_view str, std::string& out);
+
+    /// Fold str in place
+    void fold_in_place(std::string& str);
+
+private:
+    std::vector<std::int32_t> codepoints_;  // Scratch for the non-ASCII path
+};
+
+} // namespace nameanalyzer
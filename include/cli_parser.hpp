@@ -10,7 +10,21 @@ namespace nameanalyzer {
 /// Returns std::nullopt if parsing fails or help is requested
 std::optional<Config> parse_arguments(int argc, char* argv[]);
 
+/// Parse the arguments of "merge" (argv[1]) and return its options
+/// Returns std::nullopt if parsing fails or help is requested
+std::optional<MergeConfig> parse_merge_arguments(int argc, char* argv[]);
+
+/// Parse the arguments of "serve" (argv[1]) and return its options
+/// Returns std::nullopt if parsing fails or help is requested
+std::optional<ServeConfig> parse_serve_arguments(int argc, char* argv[]);
+
 /// Print usage information
 void print_usage(std::string_view program_name);
 
+/// Print usage information for the merge subcommand
+void print_merge_usage(std::string_view program_name);
+
+/// Print usage information for the serve subcommand
+void print_serve_usage(std::string_view program_name);
+
 } // namespace nameanalyzer
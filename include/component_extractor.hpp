@@ -6,7 +6,14 @@
 
 namespace nameanalyzer {
 
-/// Extract onset/nucleus/coda components from syllables
-ComponentAnalysis analyze_components(const std::vector<std::string>& words);
+/// Extract onset/nucleus/coda components from syllables, with the keys
+/// interned in strings
+ComponentAnalysis analyze_components(const std::vector<std::string>& words, StringPool& strings);
+
+/// Add one word's syllable components, weight times, to a running analysis.
+/// Components new to a map are interned in strings and start from floor
+/// (see add_count).
+void accumulate_components(const std::vector<Syllable>& syllables, ComponentAnalysis& analysis,
+                           StringPool& strings, std::size_t weight = 1, std::size_t floor = 0);
 
 } // namespace nameanalyzer
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "count_table.hpp"
+#include "string_table.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Counted context trie holding the Markov chains of every order from 1 to
+/// max_order at once. A node at depth k is a context of k symbols stored
+/// nearest-symbol-first, so the contexts of all orders at one position lie
+/// on a single path from the root: recording a transition walks that path
+/// once instead of building one context string per order.
+class ContextTrie {
+public:
+    explicit ContextTrie(int max_order = 0);
+
+    int max_order() const { return max_order_; }
+
+    /// Record the transitions of one sequence: each symbol, then `end`, is
+    /// predicted from the symbols before it, with `pad` standing in for
+    /// positions before the start (the "^^" + word + "$" convention)
+    void add_sequence(const std::vector<std::uint32_t>& symbols, std::uint32_t pad, std::uint32_t end,
+                      std::size_t weight = 1);
+
+    /// Add src's counts to this trie; remap[s] is this trie's symbol for src's s
+    void merge(const ContextTrie& src, const std::vector<std::uint32_t>& remap);
+
+    /// Lossy counting step over the transitions (see
+    /// CountTable::prune_lossy). Contexts left without transitions, here
+    /// or in any longer context below them, are freed.
+    void prune(std::size_t threshold);
+
+    /// Which of the symbols below symbol_count some context or transition uses
+    std::vector<bool> used_symbols(std::size_t symbol_count) const;
+
+    /// Give every symbol s the number renumber[s], which must keep distinct
+    /// symbols distinct
+    void renumber_symbols(const std::vector<std::uint32_t>& renumber);
+
+    /// Add the order-k chain, with symbols spelled out through `symbols`
+    /// and joined by `separator` within a context. Its keys are interned
+    /// in strings.
+    void export_chain(int order, const StringTable& symbols, MarkovChain& chain, StringPool& strings,
+                      std::string_view separator = "") const;
+
+    /// Add every order's chain to chains[order]
+    void export_chains(const StringTable& symbols, std::map<int, MarkovChain>& chains, StringPool& strings,
+                       std::string_view separator = "") const;
+
+    std::size_t node_count() const { return nodes_.size(); }
+    std::size_t transition_count() const { return transitions_.size(); }
+
+private:
+    struct Node {
+        std::uint32_t parent;
+        std::uint32_t symbol;  // Farthest symbol of this node's context
+        std::uint32_t depth;
+    };
+
+    static std::uint64_t edge_key(std::uint32_t node, std::uint32_t symbol) {
+        return (static_cast<std::uint64_t>(node) << 32) | symbol;
+    }
+
+    /// Child of node along symbol, created if missing
+    std::uint32_t child(std::uint32_t node, std::uint32_t symbol);
+
+    /// Add the transitions of one order (0 for all) to chain_of(order)
+    void export_transitions(int order, const StringTable& symbols, StringPool& strings,
+                            std::string_view separator,
+                            const std::function<MarkovChain&(int)>& chain_of) const;
+
+    /// Text of every node's context, interned in strings, indexed by node
+    std::vector<InternedString> context_texts(const StringTable& symbols, StringPool& strings,
+                                              std::string_view separator) const;
+
+    int max_order_;
+    std::vector<Node> nodes_;  // nodes_[0] is the root (empty context)
+    CountTable children_;      // edge_key(parent, symbol) -> child node
+    CountTable transitions_;   // edge_key(context node, next symbol) -> count
+};
+
+} // namespace nameanalyzer
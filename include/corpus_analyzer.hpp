@@ -0,0 +1,87 @@
+#pragma once
+
+#include "types.hpp"
+#include "utf8_word.hpp"
+#include "syllable_detector.hpp"
+#include "ngram_extractor.hpp"
+#include "syllabifier.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Single-pass corpus analysis.
+/// Each word is UTF-8 decoded and syllabified once, then fed to the letter,
+/// Markov, syllable and component accumulators together.
+class CorpusAnalyzer {
+public:
+    /// Keys are interned in strings, or in a new pool if it is null; either
+    /// way the results own it (AnalysisResults::strings)
+    explicit CorpusAnalyzer(const Config& config, std::shared_ptr<StringPool> strings = nullptr);
+
+    /// Add one word, counted as weight occurrences; words must be added in
+    /// corpus order. With config.prune_epsilon > 0, every map but the
+    /// unigrams is pruned by lossy counting after every config.batch_size
+    /// words (each weighted word counting once).
+    void add_word(std::string_view word, std::size_t weight = 1);
+
+    /// Add a batch of words, with a weight per word or, if weights is
+    /// empty, once each. With config.threads > 1 the batch is split into
+    /// contiguous shards that are analyzed concurrently and then merged in;
+    /// the results do not depend on the thread count.
+    void add_words(std::span<const std::string> words, std::span<const std::size_t> weights = {});
+
+    /// Fold in a shard built from the words that directly follow this
+    /// analyzer's words. Merging adjacent shards in any grouping gives the
+    /// same results as one analyzer over the concatenated input.
+    void merge(CorpusAnalyzer&& next);
+
+    /// Apply the final pruning, compute derived statistics and hand over
+    /// the results.
+    /// The analyzer must not be used afterwards.
+    AnalysisResults finish();
+
+    /// Wall time and allocations of the letter, syllable and component parts
+    /// of add_word, summed over merged shards. Empty unless
+    /// config.profile_stages is set.
+    const std::vector<StageTiming>& stage_timings() const { return word_stages_; }
+
+private:
+    enum WordStage { letters_stage, syllables_stage, components_stage };
+
+    void analyze_word(std::string_view word, std::size_t weight);
+
+    /// Empty results for config, as a new analyzer starts with, interning
+    /// into strings
+    void start_results(const Config& config, std::shared_ptr<StringPool> strings);
+
+    /// Forget everything counted, keeping the approximate counters'
+    /// memory, and intern into strings from now on
+    void reset(std::shared_ptr<StringPool> strings);
+
+    /// Count words added at the top level, pruning when a batch is full
+    /// and lossy counting is on
+    void words_added(std::size_t count);
+
+    AnalysisResults results_;
+    LetterCounts letter_counts_;
+    Utf8Word decoded_;                   // Reused across words
+    std::vector<std::uint32_t> codes_;   // Alphabet codes of decoded_
+    std::shared_ptr<const Syllabifier> syllabifier_;  // Shared with shards
+    std::vector<Syllable> syllables_;    // Syllables of decoded_
+    SyllableCounts syllable_counts_;
+    std::vector<std::uint32_t> syllable_ids_;  // Syllable IDs of decoded_
+    std::vector<StageTiming> word_stages_;  // Indexed by WordStage
+    std::size_t words_since_prune_ = 0;
+    std::size_t lossy_floor_ = 0;        // Last lossy counting threshold
+    std::vector<CorpusAnalyzer> shards_;  // Reused by add_words with threads
+};
+
+/// Analyze a whole word list in one pass
+AnalysisResults analyze_corpus(const std::vector<std::string>& words, const Config& config);
+
+} // namespace nameanalyzer
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Open-addressing hash table from packed 64-bit keys to counts.
+/// Used for integer-coded n-grams, where a std::map<std::string, ...>
+/// would allocate a key string and walk a tree for every occurrence.
+class CountTable {
+public:
+    /// Reserved key; never pass it to add()
+    static constexpr std::uint64_t empty_key = ~std::uint64_t{0};
+
+    /// Count stored under key, inserted as floor() if missing.
+    /// The reference is invalidated by the next insertion.
+    std::size_t& operator[](std::uint64_t key) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = slot_of(key);; i = (i + 1) & mask) {
+            if (slots_[i].key == key) {
+                return slots_[i].count;
+            }
+            if (slots_[i].key == empty_key) {
+                slots_[i].key = key;
+                slots_[i].count = floor_;
+                ++size_;
+                return slots_[i].count;
+            }
+        }
+    }
+
+    void add(std::uint64_t key, std::size_t count = 1) {
+        (*this)[key] += count;
+    }
+
+    /// Call f(key, count) for every entry, in no particular order
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& slot : slots_) {
+            if (slot.key != empty_key) {
+                f(slot.key, slot.count);
+            }
+        }
+    }
+
+    /// Remove every entry for which pred(key, count) is true. The table is
+    /// rebuilt at the size that fits the survivors, so memory is released.
+    template <typename Pred>
+    void remove_if(Pred&& pred) {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.clear();
+        shift_ = 64;
+        size_ = 0;
+        for (const auto& slot : old) {
+            if (slot.key != empty_key && !pred(slot.key, slot.count)) {
+                (*this)[slot.key] = slot.count;
+            }
+        }
+    }
+
+    /// One step of lossy counting: drop every entry counted at most
+    /// threshold times, then start new keys from threshold. Kept counts
+    /// are then never too low, and too high by at most the last threshold.
+    void prune_lossy(std::size_t threshold) {
+        remove_if([threshold](std::uint64_t, std::size_t count) { return count <= threshold; });
+        floor_ = threshold;
+    }
+
+    /// Count that new keys start from, zero by default. Lossy counting
+    /// raises it to the pruning threshold, so that a key that may have
+    /// been pruned before is never undercounted.
+    std::size_t floor() const { return floor_; }
+    void set_floor(std::size_t floor) { floor_ = floor; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    struct Slot {
+        std::uint64_t key = empty_key;
+        std::size_t count = 0;
+    };
+
+    // Fibonacci hashing: the top bits of the product are the best mixed
+    std::size_t slot_of(std::uint64_t key) const {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    void grow() {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(old.empty() ? 64 : old.size() * 2, Slot{});
+        shift_ = 64;
+        for (std::size_t n = slots_.size(); n > 1; n >>= 1) {
+            --shift_;
+        }
+        size_ = 0;
+        for (const auto& slot : old) {
+            if (slot.key != empty_key) {
+                (*this)[slot.key] = slot.count;
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+    std::size_t floor_ = 0;
+    int shift_ = 64;  // 64 - log2(slots_.size())
+};
+
+/// Most alphabet codes that fit in one packed key
+constexpr int max_packed_codes = 4;
+
+/// Pack up to max_packed_codes 16-bit alphabet codes into one key, first
+/// code highest
+inline std::uint64_t pack_codes(const std::uint32_t* codes, int n) {
+    std::uint64_t key = 0;
+    for (int i = 0; i < n; ++i) {
+        key = (key << 16) | codes[i];
+    }
+    return key;
+}
+
+/// Inverse of pack_codes
+inline void unpack_codes(std::uint64_t key, int n, std::uint32_t* codes) {
+    for (int i = n - 1; i >= 0; --i) {
+        codes[i] = static_cast<std::uint32_t>(key & 0xFFFF);
+        key >>= 16;
+    }
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Pull parser over a JSON text held in memory. The caller walks the
+/// document in order, asking for the value it expects next; anything
+/// unexpected throws std::runtime_error with the byte offset.
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text);
+
+    void begin_object();
+    /// Read the next member name into key; false at the end of the object
+    bool next_member(std::string& key);
+
+    void begin_array();
+    /// True if another element follows; false at the end of the array
+    bool next_element();
+
+    std::string read_string();
+    std::size_t read_size();
+    int read_int();
+    double read_double();
+    bool read_bool();
+
+    /// Skip over a value of any type
+    void skip_value();
+
+    /// Check that nothing but whitespace is left
+    void finish();
+
+private:
+    [[noreturn]] void fail(const std::string& what) const;
+    void skip_whitespace();
+    char peek();
+    void expect(char c);
+    /// Comma handling shared by next_member and next_element
+    bool next_item(char close);
+    void read_string_into(std::string& out);
+    std::string_view number_token();
+
+    std::string_view text_;
+    std::size_t pos_ = 0;
+    std::vector<bool> has_items_;
+};
+
+/// Load the analysis results from a JSON profile written by write_json_output
+AnalysisResults read_json_profile(const std::string& filename);
+
+} // namespace nameanalyzer
@@ -1,11 +1,68 @@
 #pragma once
 
 #include "types.hpp"
+#include "output_file.hpp"
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace nameanalyzer {
 
-/// Write analysis results to JSON file using JSOM library
-void write_json_output(const AnalysisResults& results, const std::string& filename);
+/// Streaming JSON serializer: values are written to the output as they are
+/// produced, so no document tree is ever held in memory.
+///
+/// Pretty output puts each object member on its own line, indented by two
+/// spaces per level, and keeps arrays on one line. Compact output has no
+/// whitespace at all.
+class JsonWriter {
+public:
+    JsonWriter(OutputFile& out, bool pretty);
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    /// Start an object member; the next call writes its value
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text) { value(std::string_view(text)); }
+    void value(std::size_t number);
+    void value(int number);
+    /// Six significant digits, for statistics meant to be read
+    void value(double number);
+    /// As many digits as it takes to read back the same double, for
+    /// values that programs compute with
+    void exact_value(double number);
+    void value(bool flag);
+    void null();
+
+private:
+    struct Scope {
+        bool is_array;
+        bool has_items;
+    };
+
+    void before_value();
+    void newline();
+    void write_string(std::string_view text);
+
+    OutputFile& out_;
+    bool pretty_;
+    bool after_key_ = false;
+    std::vector<Scope> scopes_;
+};
+
+/// Write one stage's measurements as an object
+void write_stage_timing(JsonWriter& json, const StageTiming& stage);
+
+/// Write stage measurements as an object keyed by stage name, in run order
+void write_stage_timings(JsonWriter& json, const std::vector<StageTiming>& stages);
+
+/// Write analysis results to a JSON file, pretty-printed unless pretty is false
+void write_json_output(const AnalysisResults& results, const std::string& filename,
+                       bool pretty = true);
 
 } // namespace nameanalyzer
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace nameanalyzer {
+
+/// Read-only view of a whole file, memory-mapped where the platform
+/// supports it. Pipes, FIFOs, terminals and other files that cannot be
+/// mapped, and every file on platforms without mmap, are read into memory.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view contents() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;  // The contents when not mapped
+};
+
+} // namespace nameanalyzer
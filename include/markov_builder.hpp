@@ -1,16 +1,38 @@
 #pragma once
 
 #include "types.hpp"
+#include "utf8_word.hpp"
+#include "alphabet.hpp"
+#include "context_trie.hpp"
+#include "approximate_counter.hpp"
+#include <cstdint>
 #include <vector>
 #include <string>
 
 namespace nameanalyzer {
 
-/// Build a Markov chain of given order from words
+/// Build a Markov chain of given order from words, with the keys interned
+/// in strings
 /// Order = number of previous characters to consider as context
-MarkovChain build_markov_chain(const std::vector<std::string>& words, int order);
+MarkovChain build_markov_chain(const std::vector<std::string>& words, int order, StringPool& strings);
 
-/// Build a Markov chain for syllables
-MarkovChain build_syllable_markov_chain(const std::vector<std::string>& syllables, int order);
+/// Record one decoded word weight times in a letter context trie, padding
+/// the start with "^" and closing with "$". codes are the word's alphabet
+/// codes.
+void add_word_to_trie(const Utf8Word& word, const std::vector<std::uint32_t>& codes,
+                      Alphabet& alphabet, ContextTrie& trie, std::size_t weight = 1);
+
+/// Count one decoded word's Markov transitions of the given order (1 to
+/// max_packed_codes - 1) in an approximate counter, with the same padding as add_word_to_trie.
+/// Items are the context codes followed by the next code, packed.
+void add_word_transitions(const Utf8Word& word, const std::vector<std::uint32_t>& codes,
+                          Alphabet& alphabet, int order, ApproximateCounter& counter,
+                          std::size_t weight = 1);
+
+/// Build a Markov chain of given order from each word's syllables. Every
+/// word is its own sequence, padded with "^" and closed with "$"; the
+/// syllables of a context are joined by "|".
+MarkovChain build_syllable_markov_chain(const std::vector<std::vector<std::string>>& words, int order,
+                                        StringPool& strings);
 
 } // namespace nameanalyzer
@@ -1,18 +1,81 @@
 #pragma once
 
 #include "types.hpp"
+#include "alphabet.hpp"
+#include "approximate_counter.hpp"
+#include "count_table.hpp"
+#include "context_trie.hpp"
+#include "utf8_word.hpp"
+#include <cstdint>
+#include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace nameanalyzer {
 
-/// Extract letter-level n-grams and statistics from word corpus
-LetterAnalysis analyze_letters(const std::vector<std::string>& words, int markov_order);
+/// Position-aware integer-coded n-gram counts
+struct PositionalCounts {
+    CountTable start;
+    CountTable middle;
+    CountTable end;
+};
+
+/// Letter n-gram counts keyed by packed alphabet codes, plus the letter
+/// Markov chains of every order in one context trie.
+/// Keys become strings only when exported into a LetterAnalysis.
+///
+/// With approximate_epsilon > 0, the two largest key spaces, 4-grams and
+/// the highest-order Markov transitions, go to fixed-size approximate
+/// counters instead; the trie then holds the lower orders only.
+struct LetterCounts {
+    explicit LetterCounts(int markov_order = 0, double approximate_epsilon = 0.0);
+
+    /// Forget every count, keeping the approximate counters' memory
+    void clear();
+
+    Alphabet alphabet;
+    std::vector<std::size_t> unigrams;  // Indexed by alphabet code
+    CountTable bigrams;
+    CountTable trigrams;
+    CountTable fourgrams;
+    PositionalCounts positional_bigrams;
+    PositionalCounts positional_trigrams;
+    ContextTrie markov;
+    int markov_order;
+    std::optional<ApproximateCounter> approximate_fourgrams;
+    std::optional<ApproximateCounter> approximate_markov;  // Order markov_order only, if at most 3
+};
+
+/// Extract letter-level n-grams and statistics from word corpus, with the
+/// keys interned in strings
+LetterAnalysis analyze_letters(const std::vector<std::string>& words, int markov_order, StringPool& strings);
+
+/// Count one word's n-grams and Markov transitions, weight times each.
+/// codes is scratch space that receives the word's alphabet codes.
+void count_letters(const Utf8Word& word, LetterCounts& counts, std::vector<std::uint32_t>& codes,
+                   std::size_t weight = 1);
+
+/// Add src's counts to dst, translating between the two alphabets
+void merge_letter_counts(LetterCounts& dst, const LetterCounts& src);
+
+/// Lossy counting step over the n-grams and Markov transitions (see
+/// CountTable::prune_lossy). Unigrams are left alone; there is one slot per
+/// letter anyway.
+void prune_letter_counts(LetterCounts& counts, std::size_t threshold);
+
+/// Add the counts to the string-keyed n-gram maps and Markov chains of
+/// analysis, interning new keys in strings
+void export_letter_counts(const LetterCounts& counts, LetterAnalysis& analysis, StringPool& strings);
 
 /// Extract n-grams of specific size from a word
-void extract_ngrams(std::string_view word, int n, FrequencyMap& ngrams);
+void extract_ngrams(std::string_view word, int n, FrequencyMap& ngrams, StringPool& strings);
+void extract_ngrams(const Utf8Word& word, int n, FrequencyMap& ngrams, StringPool& strings);
 
 /// Extract positional n-grams (start, middle, end)
-void extract_positional_ngrams(std::string_view word, int n, PositionalFrequencies& pos_freq);
+void extract_positional_ngrams(std::string_view word, int n, PositionalFrequencies& pos_freq,
+                               StringPool& strings);
+void extract_positional_ngrams(const Utf8Word& word, int n, PositionalFrequencies& pos_freq,
+                               StringPool& strings);
 
 } // namespace nameanalyzer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#endif
+
+namespace nameanalyzer {
+
+/// Write-only file with its own output buffer, so that many small writes
+/// cost one system call per buffer rather than one each
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& filename, std::size_t buffer_size = 1 << 16);
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    void write(std::string_view data);
+
+    void put(char c) {
+        if (used_ == buffer_.size()) {
+            flush();
+        }
+        buffer_[used_++] = c;
+    }
+
+    /// Flush buffered data and close the file, reporting any write error.
+    /// The destructor closes an open file too, but cannot report errors.
+    void close();
+
+private:
+    void flush();
+
+    std::string filename_;
+    std::vector<char> buffer_;
+    std::size_t used_ = 0;
+#if defined(_WIN32)
+    std::ofstream file_;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace nameanalyzer
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+/// On-disk layout of binary profiles (.nap files), shared by the writer and
+/// the reader.
+///
+/// A profile holds the same tables as the JSON output, laid out so that it
+/// can be memory-mapped and used without parsing:
+///
+///   ProfileHeader
+///   TableRecord[table_count]       sorted by table name
+///   uint64_t string_offsets[string_count + 1]
+///   char     string_data[]         string i is data[offsets[i], offsets[i+1])
+///   per table, each array starting on an 8-byte boundary:
+///     uint32_t row_keys[row_count]         context strings, sorted by bytes
+///     uint32_t row_starts[row_count + 1]   first entry of each row
+///     uint32_t entry_symbols[entry_count]  next-symbol strings
+///     uint64_t entry_cumulative[entry_count]
+///
+/// A table is a set of rows in compressed sparse row form. Markov chains
+/// have one row per context; frequency maps are a single row keyed by the
+/// empty string. entry_cumulative is the running total of the counts in a
+/// row, so the last value of a row is its total and a symbol can be drawn
+/// with one binary search for a uniform value in [0, total).
+///
+/// Table names follow the JSON paths, for example "letter_analysis.unigrams",
+/// "letter_analysis.positional_bigrams.start" or
+/// "syllable_analysis.syllable_markov.order_2".
+///
+/// All integers are in the byte order of the machine that wrote the file;
+/// readers reject files whose byte-order mark does not match their own.
+namespace nameanalyzer::profile_format {
+
+inline constexpr char magic[8] = {'N', 'A', 'P', 'R', 'O', 'F', 'I', 'L'};
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+/// Flag bits of ProfileHeader::flags
+inline constexpr std::uint32_t syllables_enabled = 1u << 0;
+inline constexpr std::uint32_t components_enabled = 1u << 1;
+
+struct ProfileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order_mark;
+    std::uint64_t file_size;
+
+    std::uint32_t string_count;
+    std::uint32_t table_count;
+    std::uint64_t string_offsets_offset;
+    std::uint64_t string_data_offset;
+    std::uint64_t tables_offset;
+
+    // Analysis configuration and corpus statistics
+    std::int32_t markov_order;
+    std::int32_t min_word_length;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    std::uint64_t total_words;
+    std::uint64_t total_characters;
+    std::uint64_t total_syllables;
+    double avg_word_length;
+    double avg_syllables_per_word;
+};
+
+struct TableRecord {
+    std::uint32_t name;          // string index
+    std::uint32_t order;         // Markov order, 0 for frequency tables
+    std::uint32_t row_count;
+    std::uint32_t entry_count;
+    std::uint64_t row_keys_offset;
+    std::uint64_t row_starts_offset;
+    std::uint64_t entry_symbols_offset;
+    std::uint64_t entry_cumulative_offset;
+};
+
+static_assert(sizeof(ProfileHeader) == 112, "ProfileHeader layout must not change");
+static_assert(sizeof(TableRecord) == 48, "TableRecord layout must not change");
+
+} // namespace nameanalyzer::profile_format
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// One frequency map ranked for lookups: entries by descending count, ties
+/// in key order, with an optional index from key to position
+struct RankedCounts {
+    std::size_t total = 0;
+    std::vector<std::pair<std::string_view, std::size_t>> entries;
+    std::unordered_map<std::string_view, std::size_t> positions;  // Empty unless indexed
+
+    /// Count and 1-based rank of key; both 0 if absent. Needs the index.
+    std::pair<std::size_t, std::size_t> find(std::string_view key) const;
+};
+
+/// Read-only lookup structures over a profile, built once so that queries
+/// are hash lookups into precomputed rankings (see `nameanalyzer serve`).
+/// Keys are views into the string pools of the index's results, which
+/// copies of the index share. Safe to query from any number of threads.
+class ProfileIndex {
+public:
+    explicit ProfileIndex(AnalysisResults results);
+
+    /// A frequency map by its name: "unigrams" to "fourgrams", "syllables",
+    /// "onsets", "nuclei" and "codas", and the positional maps as
+    /// "bigrams.start", "trigrams.middle", "syllables.end", "onsets.start",
+    /// "codas.end" and so on. nullptr if there is no such map.
+    const RankedCounts* table(std::string_view name) const;
+
+    /// What follows a letter context, such as "^^s" or "str"; the order is
+    /// the context's length. nullptr if the context was never seen.
+    const RankedCounts* next_letter(std::string_view context) const;
+
+    /// What follows a syllable context, such as "^|per"; the order is the
+    /// number of syllables. nullptr if the context was never seen.
+    const RankedCounts* next_syllable(std::string_view context) const;
+
+    const AnalysisResults& results() const { return results_; }
+
+private:
+    void add_table(std::string name, const FrequencyMap& counts);
+
+    AnalysisResults results_;
+    std::map<std::string, RankedCounts, std::less<>> tables_;
+    // Contexts of every order together: their lengths tell them apart
+    std::unordered_map<std::string_view, RankedCounts> letter_contexts_;
+    std::unordered_map<std::string_view, RankedCounts> syllable_contexts_;
+};
+
+} // namespace nameanalyzer
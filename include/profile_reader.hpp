@@ -0,0 +1,101 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "profile_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nameanalyzer {
+
+class ProfileReader;
+
+/// One row of a profile table: the symbols that follow a context, with
+/// their cumulative counts
+class ProfileRow {
+public:
+    std::string_view context() const;
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    std::string_view symbol(std::size_t index) const;
+    std::uint64_t count(std::size_t index) const {
+        return cumulative_[index] - (index > 0 ? cumulative_[index - 1] : 0);
+    }
+    std::uint64_t total() const { return size_ > 0 ? cumulative_[size_ - 1] : 0; }
+
+    /// Index of the entry whose cumulative range holds value; draw value
+    /// uniformly from [0, total()) to sample by frequency
+    std::size_t sample_index(std::uint64_t value) const;
+    std::string_view sample(std::uint64_t value) const { return symbol(sample_index(value)); }
+
+private:
+    friend class ProfileTable;
+
+    const ProfileReader* profile_ = nullptr;
+    std::uint32_t context_ = 0;
+    const std::uint32_t* symbols_ = nullptr;
+    const std::uint64_t* cumulative_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// A table of a binary profile: a Markov chain with one row per context, or
+/// a frequency map stored as a single row
+class ProfileTable {
+public:
+    std::string_view name() const;
+    std::uint32_t order() const { return record_->order; }
+    std::size_t row_count() const { return record_->row_count; }
+    std::size_t entry_count() const { return record_->entry_count; }
+
+    ProfileRow row(std::size_t index) const;
+
+    /// The row for a context, found by binary search
+    std::optional<ProfileRow> find(std::string_view context) const;
+
+    /// The single row of a frequency table
+    ProfileRow frequencies() const { return row(0); }
+
+private:
+    friend class ProfileReader;
+
+    const ProfileReader* profile_ = nullptr;
+    const profile_format::TableRecord* record_ = nullptr;
+    const std::uint32_t* row_keys_ = nullptr;
+    const std::uint32_t* row_starts_ = nullptr;
+    const std::uint32_t* symbols_ = nullptr;
+    const std::uint64_t* cumulative_ = nullptr;
+};
+
+/// Memory-mapped binary profile, as written by write_binary_profile.
+///
+/// Opening a profile checks the header and the bounds of each table and
+/// reads nothing else; tables, rows and strings are views into the mapping
+/// and stay valid for the lifetime of the reader.
+class ProfileReader {
+public:
+    explicit ProfileReader(const std::string& filename);
+
+    const profile_format::ProfileHeader& header() const { return *header_; }
+
+    std::size_t string_count() const { return header_->string_count; }
+    std::string_view string(std::uint32_t id) const;
+
+    std::size_t table_count() const { return header_->table_count; }
+    ProfileTable table(std::size_t index) const;
+
+    /// A table by name (for example "letter_analysis.markov_chains.order_2")
+    std::optional<ProfileTable> find_table(std::string_view name) const;
+
+private:
+    MappedFile file_;
+    const profile_format::ProfileHeader* header_ = nullptr;
+    const profile_format::TableRecord* tables_ = nullptr;
+    const std::uint64_t* string_offsets_ = nullptr;
+    const char* string_data_ = nullptr;
+    std::uint64_t string_bytes_ = 0;
+};
+
+} // namespace nameanalyzer
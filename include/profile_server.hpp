@@ -0,0 +1,68 @@
+#pragma once
+
+#include "types.hpp"
+#include "profile_index.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace nameanalyzer {
+
+/// Distribution of query latencies in log-linear buckets, 8 per power of
+/// two, so percentiles are accurate to within 12.5%. Recording is lock-free
+/// and can happen on any number of threads.
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds latency);
+
+    std::uint64_t count() const;
+
+    /// Microseconds that the fraction q of the latencies do not exceed
+    double percentile_us(double q) const;
+
+    double max_us() const { return static_cast<double>(max_ns_.load(std::memory_order_relaxed)) / 1000.0; }
+
+    /// "queries <n> p50 <us> p90 <us> p99 <us> p999 <us> max <us>"
+    std::string summary() const;
+
+private:
+    static constexpr std::size_t sub_buckets = 8;
+    static constexpr std::size_t num_buckets = 64 * sub_buckets;
+
+    static std::size_t bucket_of(std::uint64_t ns);
+    static std::uint64_t bucket_limit(std::size_t bucket);  // Largest latency in the bucket
+
+    std::array<std::atomic<std::uint64_t>, num_buckets> counts_{};
+    std::atomic<std::uint64_t> max_ns_{0};
+};
+
+/// Answer one request line of the serve protocol, appending the response
+/// line (with its newline) to out. Every request gets exactly one line:
+///
+///     next <context> [k]     ok <total> <letter> <count> ...
+///     snext <context> [k]    ok <total> <syllable> <count> ...
+///     top <table> [k]        ok <total> <key> <count> ...
+///     count <table> <key>    ok <count> <total> <rank>
+///     stats                  ok words <n> characters <n> syllables <n>
+///     latency                ok queries <n> p50 <us> p90 <us> p99 <us> p999 <us> max <us>
+///
+/// Lists are ordered by descending count and cut to the k first entries
+/// if k is given. Contexts and tables are those of ProfileIndex; unknown
+/// contexts answer "ok 0". The empty key is written "". Malformed requests
+/// answer "err <message>".
+void answer_query(const ProfileIndex& index, const LatencyHistogram& latency, std::string_view request,
+                  std::string& out);
+
+/// Serve index on a Unix domain socket at socket_path until SIGINT or
+/// SIGTERM, one thread per client. Clients send any number of request
+/// lines at once and receive the responses in order; "quit" closes the
+/// connection. The latency of every query is recorded and the percentiles
+/// printed on shutdown. Throws std::runtime_error if the socket cannot be
+/// created, or on platforms without Unix domain sockets.
+void serve_profile(const ProfileIndex& index, const std::string& socket_path, bool verbose);
+
+} // namespace nameanalyzer
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "types.hpp"
+#include <string>
+
+namespace nameanalyzer {
+
+/// Write analysis results as a memory-mappable binary profile
+/// (see profile_format.hpp for the layout)
+void write_binary_profile(const AnalysisResults& results, const std::string& filename);
+
+} // namespace nameanalyzer
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace nameanalyzer {
+
+// Pruning of rare entries (--min-count, --top-k-per-context). Entries are
+// dropped, never rescaled, so the counts that remain are the same as
+// without pruning up to what was dropped before they reached min_count.
+
+/// Drop every entry counted fewer than min_count times
+void prune_frequencies(FrequencyMap& freq_map, std::size_t min_count);
+void prune_positional(PositionalFrequencies& pos_freq, std::size_t min_count);
+
+/// Drop transitions counted fewer than min_count times, then keep at most
+/// top_k transitions per context (0 keeps all), preferring higher counts
+/// and, among equal counts, the smaller key. Contexts left without
+/// transitions are removed.
+void prune_markov_chain(MarkovChain& chain, std::size_t min_count, std::size_t top_k);
+void prune_markov_chains(std::map<int, MarkovChain>& chains, std::size_t min_count, std::size_t top_k);
+
+/// Drop rare syllables everywhere, including all_syllables, which keeps
+/// the order of the syllables that remain. Only min_count applies to the
+/// Markov chains here; the top-k cut is left for prune_results.
+void prune_syllable_analysis(SyllableAnalysis& analysis, std::size_t min_count);
+void prune_component_analysis(ComponentAnalysis& analysis, std::size_t min_count);
+
+/// Apply config.min_count and config.top_k_per_context to every section of
+/// results, then compact_strings(). The statistics are not touched; they
+/// always cover every word.
+void prune_results(AnalysisResults& results);
+
+/// Dropping an entry leaves its text in the pool, which is only freed as a
+/// whole. Once the pools of results hold more than twice as many strings
+/// as its maps have keys, move every key to a new pool of just those, and
+/// drop the old pools from the results. Returns whether it did.
+bool compact_strings(AnalysisResults& results);
+
+/// table's strings, interned in strings instead, in the same order
+StringTable move_strings(const StringTable& table, StringPool& strings);
+
+} // namespace nameanalyzer
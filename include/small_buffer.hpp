@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace nameanalyzer {
+
+/// Growable array of trivially copyable values that stores up to N of them
+/// inline and moves to the heap only beyond that. Once grown it keeps its
+/// heap block, so a buffer reused across many short inputs allocates at
+/// most a few times over its whole life.
+template <typename T, std::size_t N>
+class SmallBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallBuffer holds plain values only");
+
+public:
+    SmallBuffer() = default;
+
+    SmallBuffer(const SmallBuffer& other) { *this = other; }
+
+    SmallBuffer& operator=(const SmallBuffer& other) {
+        if (this != &other) {
+            resize(other.size_);
+            std::copy(other.data_, other.data_ + other.size_, data_);
+        }
+        return *this;
+    }
+
+    SmallBuffer(SmallBuffer&& other) noexcept { *this = std::move(other); }
+
+    SmallBuffer& operator=(SmallBuffer&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            data_ = heap_.get();
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+        } else {
+            // Inline contents fit in any buffer
+            size_ = other.size_;
+            std::copy(other.data_, other.data_ + other.size_, data_);
+        }
+        other.data_ = other.inline_;
+        other.capacity_ = N;
+        other.size_ = 0;
+        return *this;
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    void clear() { size_ = 0; }
+
+    void push_back(T value) {
+        if (size_ == capacity_) {
+            reserve(2 * capacity_);
+        }
+        data_[size_++] = value;
+    }
+
+    /// Change the size; new elements are left uninitialized
+    void resize(std::size_t size) {
+        reserve(size);
+        size_ = size;
+    }
+
+    void reserve(std::size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        std::unique_ptr<T[]> grown(new T[capacity]);  // Uninitialized, like the inline storage
+        std::copy(data_, data_ + size_, grown.get());
+        heap_ = std::move(grown);
+        data_ = heap_.get();
+        capacity_ = capacity;
+    }
+
+private:
+    T inline_[N];
+    std::unique_ptr<T[]> heap_;
+    T* data_ = inline_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = N;
+};
+
+} // namespace nameanalyzer
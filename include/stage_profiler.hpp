@@ -0,0 +1,95 @@
+#pragma once
+
+#include "types.hpp"
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Heap allocations made through operator new, in any of its forms. C code
+/// that calls malloc directly is not seen.
+struct AllocationCounts {
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+};
+
+/// Start counting allocations. Call before any worker thread starts;
+/// counting costs a few atomic adds per allocation, so it is off by default.
+/// Allocations are only seen by programs that link src/allocation_hooks.cpp,
+/// which replaces the global operator new (plain, array, nothrow and
+/// aligned); the library leaves it alone.
+void enable_allocation_counting();
+
+/// Record one allocation of size bytes, if counting is enabled
+void count_allocation(std::size_t size);
+
+/// Allocations made by every thread since counting was enabled
+AllocationCounts process_allocations();
+
+/// Allocations made by the calling thread since counting was enabled
+AllocationCounts thread_allocations();
+
+/// User plus system CPU time of the whole process
+double process_cpu_seconds();
+
+/// Reset the peak resident set size to the current one, where the platform
+/// allows it (Linux). Returns false if peaks stay process-wide.
+bool reset_peak_rss();
+
+/// Peak resident set size, in KiB, if the platform reports it
+std::optional<long> peak_rss_kb();
+
+/// A moment in time and in the calling thread's allocations, for charging
+/// the work done since then to a stage. Only wall time and allocations can
+/// be split this finely; CPU time and RSS are per process.
+struct StageMark {
+    std::chrono::steady_clock::time_point time;
+    AllocationCounts allocations;
+
+    static StageMark now();
+
+    /// Add the time and allocations since this mark to stage, and move the
+    /// mark to the present
+    void charge(StageTiming& stage);
+};
+
+/// Sum other's wall time and allocations into stage
+void add_stage_timing(StageTiming& stage, const StageTiming& other);
+
+/// Records the resources used by the top-level stages of a run. A stage can
+/// be entered several times (reading and analysis alternate per batch);
+/// its figures accumulate.
+class StageProfiler {
+public:
+    void begin(std::string_view stage);
+    void end();
+
+    /// Add a stage measured elsewhere, such as the parts of the analysis pass
+    void add(const StageTiming& stage);
+
+    const std::vector<StageTiming>& stages() const { return stages_; }
+
+    /// Resources used from construction until now
+    StageTiming total() const;
+
+private:
+    struct Start {
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        double cpu_seconds = process_cpu_seconds();
+        AllocationCounts allocations = process_allocations();
+    };
+
+    std::vector<StageTiming> stages_;
+    std::size_t current_ = 0;
+    Start stage_start_;
+    Start run_start_;
+};
+
+/// Write the stages of a run to a JSON file
+void write_stage_profile(const StageProfiler& profiler, const Config& config, const std::string& filename);
+
+} // namespace nameanalyzer
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace nameanalyzer {
+
+class StringPool;
+
+/// Handle to a string held by a StringPool: as cheap to copy as a
+/// string_view, and valid for as long as that pool is. Handles order and
+/// compare like the text they name, so ordered maps keyed on them iterate
+/// exactly like maps keyed on strings, and text can be looked up without
+/// interning it. Equal handles from one pool share their bytes.
+class InternedString {
+public:
+    /// The empty string, which belongs to no pool
+    InternedString() = default;
+
+    std::string_view view() const { return view_; }
+    operator std::string_view() const { return view_; }
+
+    const char* data() const { return view_.data(); }
+    std::size_t size() const { return view_.size(); }
+    bool empty() const { return view_.empty(); }
+
+    friend bool operator==(const InternedString& a, const InternedString& b) {
+        return (a.view_.data() == b.view_.data() && a.view_.size() == b.view_.size()) || a.view_ == b.view_;
+    }
+    friend std::strong_ordering operator<=>(const InternedString& a, const InternedString& b) {
+        if (a.view_.data() == b.view_.data() && a.view_.size() == b.view_.size()) {
+            return std::strong_ordering::equal;
+        }
+        return a.view_ <=> b.view_;
+    }
+
+    // Comparison with plain text, for lookups that should not intern
+    template <typename Text>
+        requires(std::is_convertible_v<const Text&, std::string_view> &&
+                 !std::is_same_v<Text, InternedString>)
+    friend bool operator==(const InternedString& a, const Text& b) {
+        return a.view_ == std::string_view(b);
+    }
+    template <typename Text>
+        requires(std::is_convertible_v<const Text&, std::string_view> &&
+                 !std::is_same_v<Text, InternedString>)
+    friend std::strong_ordering operator<=>(const InternedString& a, const Text& b) {
+        return a.view_ <=> std::string_view(b);
+    }
+
+private:
+    friend class StringPool;
+    explicit InternedString(std::string_view view) : view_(view) {}
+
+    std::string_view view_;
+};
+
+/// Arena holding each distinct string once, for the keys of analysis maps.
+/// The same syllable or n-gram in many maps, and in every copy of them, is
+/// then one handle to the same bytes rather than a string each. Text is
+/// only freed with the pool itself, which is why results own their pool
+/// (AnalysisResults::strings) rather than sharing one process-wide.
+///
+/// Interning is thread-safe, so analysis shards can share their analyzer's
+/// pool.
+class StringPool {
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /// Handle to str's text, copied into the pool if it is new.
+    /// Throws std::runtime_error for strings of 4 GiB or more.
+    InternedString intern(std::string_view str);
+
+    /// Number of distinct strings held, including any no map uses anymore
+    std::size_t size() const { return count_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t shard_bits = 4;
+
+    /// One lock's worth of the pool: an open-addressing set of views into
+    /// its own arena blocks. A std::unordered_set would cost a node
+    /// allocation per string, more than most of the strings themselves.
+    struct Shard {
+        struct Slot {
+            const char* data = nullptr;  // nullptr marks a free slot
+            std::uint32_t size = 0;
+            std::uint32_t hash = 0;      // Low bits of the full hash
+        };
+
+        std::mutex mutex;
+        std::vector<Slot> slots;  // Power-of-two size
+        std::size_t count = 0;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* next = nullptr;     // Free space in the current block
+        std::size_t left = 0;
+        std::size_t last_block = 0;  // Size of the last regular block
+
+        std::string_view intern(std::string_view str, std::uint64_t hash, bool& added);
+        void grow();
+        const char* store(std::string_view str);
+    };
+
+    std::array<Shard, std::size_t{1} << shard_bits> shards_;
+    std::atomic<std::size_t> count_{0};
+};
+
+} // namespace nameanalyzer
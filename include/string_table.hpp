@@ -0,0 +1,45 @@
+#pragma once
+
+#include "string_pool.hpp"
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Insertion-ordered set of unique strings with stable integer IDs.
+/// Lookups are hashed, so inserting n strings costs O(n) rather than the
+/// O(n^2) of a linear scan over a vector. The strings are handles into
+/// whichever pools they were interned in, which must outlive the table.
+class StringTable {
+public:
+    using const_iterator = std::vector<InternedString>::const_iterator;
+
+    /// Return the ID of str, adding it to the end of the table if new
+    std::size_t intern(InternedString str);
+
+    /// Likewise for plain text, interned in strings only if it is new
+    std::size_t intern(std::string_view str, StringPool& strings);
+
+    /// Return the ID of str if present
+    std::optional<std::size_t> find(std::string_view str) const;
+
+    bool contains(std::string_view str) const { return find(str).has_value(); }
+
+    const InternedString& operator[](std::size_t id) const { return strings_[id]; }
+    std::size_t size() const { return strings_.size(); }
+    bool empty() const { return strings_.empty(); }
+
+    const_iterator begin() const { return strings_.begin(); }
+    const_iterator end() const { return strings_.end(); }
+
+private:
+    // Interned text never moves, so the index can key on views of it and
+    // a copied table shares them with the original
+    std::vector<InternedString> strings_;
+    std::unordered_map<std::string_view, std::size_t> index_;
+};
+
+} // namespace nameanalyzer
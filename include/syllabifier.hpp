@@ -0,0 +1,71 @@
+#pragma once
+
+#include "types.hpp"
+#include "string_table.hpp"
+#include "utf8_word.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nameanalyzer {
+
+/// Read a phoneme-class description (--phonemes). One class per line,
+/// named before a colon and followed by its entries, separated by spaces;
+/// "#" starts a comment:
+///
+///     vowels: a e i o u y á é í ó ú
+///     glides: w
+///     onsets: bl br ch cl cr dr fl fr gl gr pl pr sh st str th tr
+///
+/// Entries are case-folded like the input words. Throws std::runtime_error
+/// if the file cannot be read, names an unknown class or has no vowels.
+PhonemeClasses read_phoneme_file(const std::string& filename);
+
+/// Splits decoded words into onset-nucleus-coda syllables by a phoneme
+/// description compiled into a dense codepoint-class table.
+///
+/// A nucleus is a maximal run of vowels. A glide counts as a vowel except
+/// at the start of a word or right before a vowel, where it is a consonant
+/// (the "y" of "yara" and "maya", but not of "day"). The consonants between
+/// two nuclei go to the second syllable's onset as far as the permitted
+/// onsets allow (always at least one); the rest close the first syllable.
+/// Without an onset list, all but the first consonant of a cluster go to
+/// the onset. A word without vowels is a single syllable of onset only.
+class Syllabifier {
+public:
+    /// Compile classes. Each vowel and glide is classified in both its
+    /// given and its uppercase form. Throws std::runtime_error if a vowel
+    /// or glide is not exactly one codepoint, or is both.
+    explicit Syllabifier(const PhonemeClasses& classes = PhonemeClasses{});
+
+    /// Split word, reusing the storage of syllables
+    void split(const Utf8Word& word, std::vector<Syllable>& syllables) const;
+
+private:
+    enum Class : std::uint8_t { consonant, vowel, glide };
+
+    static constexpr std::uint32_t codepoint_limit = 0x110000;
+    using Page = std::array<Class, 256>;
+
+    // One bounds check and two loads; invalid bytes (-1) are consonants
+    Class class_of(std::int32_t codepoint) const {
+        auto cp = static_cast<std::uint32_t>(codepoint);
+        return cp < codepoint_limit ? pages_[page_index_[cp >> 8]][cp & 0xFF] : consonant;
+    }
+
+    void set_class(std::int32_t codepoint, Class value);
+
+    /// Codepoints of the cluster [first, last) that stay in the previous
+    /// syllable's coda
+    std::size_t coda_length(const Utf8Word& word, std::size_t first, std::size_t last) const;
+
+    std::vector<std::uint16_t> page_index_;  // Codepoint >> 8 -> page; page 0 is all consonants
+    std::vector<Page> pages_;
+    StringPool onset_strings_;
+    StringTable onsets_;                     // Interned in onset_strings_
+    std::size_t max_onset_length_ = 0;       // In codepoints
+};
+
+} // namespace nameanalyzer
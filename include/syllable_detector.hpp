@@ -1,6 +1,10 @@
 #pragma once
 
 #include "types.hpp"
+#include "context_trie.hpp"
+#include "string_table.hpp"
+#include "utf8_word.hpp"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -13,10 +17,50 @@ bool is_vowel(char c);
 /// Detect if a character is a consonant
 bool is_consonant(char c);
 
-/// Split a word into syllables using heuristic rules
+/// Split a word into syllables with the default Syllabifier (Latin vowels)
 std::vector<Syllable> detect_syllables(std::string_view word);
+std::vector<Syllable> detect_syllables(const Utf8Word& word);
 
-/// Analyze syllables from word corpus
-SyllableAnalysis analyze_syllables(const std::vector<std::string>& words, int markov_order);
+/// Syllable Markov chains of every order, counted on integer syllable IDs
+/// in one context trie. Each word is its own sequence, padded with "^"
+/// and closed with "$" like the letter chains, so chains never run from
+/// one word into the next.
+/// IDs become strings only when exported into a SyllableAnalysis.
+struct SyllableCounts {
+    static constexpr std::uint32_t pad_symbol = 0;  // "^"
+    static constexpr std::uint32_t end_symbol = 1;  // "$"
+
+    /// The syllables are interned in strings, which must outlive the counts
+    SyllableCounts(int markov_order, StringPool& strings);
+
+    StringTable symbols;  // Syllable IDs, after the two markers
+    ContextTrie markov;
+};
+
+/// Add one word's syllables, weight times, to a running analysis: the
+/// frequency maps of analysis directly, the Markov transitions to counts.
+/// ids is scratch space that receives the word's syllable IDs. New
+/// syllables are interned in strings, the pool counts was made with, and
+/// start from floor in the frequency maps (see add_count).
+void accumulate_syllables(const std::vector<Syllable>& syllables, SyllableAnalysis& analysis,
+                          SyllableCounts& counts, std::vector<std::uint32_t>& ids, StringPool& strings,
+                          std::size_t weight = 1, std::size_t floor = 0);
+
+/// Lossy counting step over the transitions (see ContextTrie::prune).
+/// Syllables no longer in any context or transition lose their IDs, and
+/// the others are renumbered in the same order.
+void prune_syllable_counts(SyllableCounts& counts, std::size_t threshold);
+
+/// Add src's transitions to dst, translating between their syllable IDs
+void merge_syllable_counts(SyllableCounts& dst, const SyllableCounts& src);
+
+/// Add the transitions to the string-keyed syllable_markov chains of
+/// analysis, with the syllables of a context joined by "|" and interned in
+/// strings
+void export_syllable_counts(const SyllableCounts& counts, SyllableAnalysis& analysis, StringPool& strings);
+
+/// Analyze syllables from word corpus, with the keys interned in strings
+SyllableAnalysis analyze_syllables(const std::vector<std::string>& words, int markov_order,
+                                   StringPool& strings);
 
 } // namespace nameanalyzer
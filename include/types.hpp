@@ -1,21 +1,79 @@
 #pragma once
 
+#include "string_pool.hpp"
+#include "string_table.hpp"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <optional>
 
 namespace nameanalyzer {
 
+/// Phoneme classes that drive syllabification (--phonemes). The defaults
+/// are the Latin vowels, no glides and no onset list.
+struct PhonemeClasses {
+    std::vector<std::string> vowels = {"a", "e", "i", "o", "u", "y"};
+    std::vector<std::string> glides;  // Consonants before a vowel or at the start of a word, else vowels
+    std::vector<std::string> onsets;  // Consonant clusters a syllable may start with
+
+    bool operator==(const PhonemeClasses&) const = default;
+};
+
+/// Highest Markov order accepted from a profile. Longer contexts are too
+/// sparse to be useful, and a bogus order would size tables per order.
+constexpr int max_markov_order = 10;
+
 /// Configuration options from CLI
 struct Config {
     std::string input_file;
     std::string output_file;
+    std::string binary_output_file; // Optional memory-mappable profile
+    std::string update_profile;     // Existing JSON profile to add the input to
     int markov_order = 3;           // Default to 2nd order
     bool enable_syllables = true;
     bool enable_components = true;
     int min_word_length = 2;        // Ignore very short words
     bool verbose = false;
+    int threads = 1;                // Analysis worker threads
+    std::size_t batch_size = 65536; // Words read and analyzed per batch
+    bool weighted_input = false;    // Input lines are "word<TAB>count"
+    bool dedupe = false;            // Collapse repeated words into weights first
+    bool compact_output = false;    // JSON without indentation
+    std::size_t min_count = 1;          // Drop entries counted fewer times
+    std::size_t top_k_per_context = 0;  // Markov transitions kept per context; 0 keeps all
+    double approximate_epsilon = 0.0;   // Sketch 4-grams and top-order transitions; 0 counts exactly
+    double prune_epsilon = 0.0;         // Lossy counting of every map per batch; 0 keeps all
+    bool sampling_tables = false;       // Add probability and alias tables to the output
+    std::string phonemes_file;          // Where phonemes was read from, if not the defaults
+    PhonemeClasses phonemes;            // Syllabification rules
+    bool profile_stages = false;    // Measure time and memory per stage
+    std::string stage_profile_file; // Where to write the stage measurements
+    bool embed_timings = false;     // Also add them to the output as stats.timings
+};
+
+/// Options of the merge subcommand
+struct MergeConfig {
+    std::vector<std::string> input_files; // JSON profiles, in corpus order
+    std::string output_file;
+    std::string binary_output_file;
+    bool compact_output = false;
+    std::size_t min_count = 1;          // Pruning applied to the merged profile
+    std::size_t top_k_per_context = 0;
+    bool sampling_tables = false;
+    bool force = false;                 // Merge pruned or approximate profiles too
+    bool verbose = false;
+};
+
+/// Options of the serve subcommand
+struct ServeConfig {
+    std::string profile_file;     // JSON profile to serve
+    std::string words_file;       // Or a word list to analyze first
+    std::string socket_path;      // Unix domain socket to listen on
+    int threads = 1;              // Threads for analyzing words_file
+    bool verbose = false;
 };
 
 /// Position in word for position-aware analysis
@@ -25,8 +83,33 @@ enum class Position {
     End
 };
 
-/// Frequency map for n-grams or syllables
-using FrequencyMap = std::map<std::string, std::size_t>;
+/// Frequency map for n-grams or syllables. Keys are interned in a
+/// StringPool, normally their results' (AnalysisResults::strings), so the
+/// same text in many maps is stored once and copying a map copies handles
+/// rather than strings. std::less<> allows lookups by plain text.
+using FrequencyMap = std::map<InternedString, std::size_t, std::less<>>;
+
+/// Add count to key's entry, interning key in strings only if the map
+/// lacks it. A new entry starts from floor, which lossy counting raises
+/// (see CountTable::floor).
+inline void add_count(FrequencyMap& freq_map, StringPool& strings, std::string_view key,
+                      std::size_t count = 1, std::size_t floor = 0) {
+    auto it = freq_map.lower_bound(key);
+    if (it == freq_map.end() || it->first != key) {
+        it = freq_map.emplace_hint(it, strings.intern(key), floor);
+    }
+    it->second += count;
+}
+
+/// Add count to the entry of a key that is interned already
+inline void add_count(FrequencyMap& freq_map, InternedString key, std::size_t count = 1,
+                      std::size_t floor = 0) {
+    auto it = freq_map.lower_bound(key);
+    if (it == freq_map.end() || it->first != key) {
+        it = freq_map.emplace_hint(it, key, floor);
+    }
+    it->second += count;
+}
 
 /// Position-aware frequency maps
 struct PositionalFrequencies {
@@ -36,8 +119,18 @@ struct PositionalFrequencies {
 };
 
 /// Markov chain: given context (previous n chars/syllables), what comes next?
-/// Maps context -> {next_item -> frequency}
-using MarkovChain = std::map<std::string, FrequencyMap>;
+/// Maps context -> {next_item -> frequency}, interned like FrequencyMap
+using MarkovChain = std::map<InternedString, FrequencyMap, std::less<>>;
+
+/// Transitions out of context, interning context in strings only if the
+/// chain lacks it
+inline FrequencyMap& context_counts(MarkovChain& chain, StringPool& strings, std::string_view context) {
+    auto it = chain.lower_bound(context);
+    if (it == chain.end() || it->first != context) {
+        it = chain.emplace_hint(it, strings.intern(context), FrequencyMap{});
+    }
+    return it->second;
+}
 
 /// Syllable structure (onset-nucleus-coda)
 struct Syllable {
@@ -72,7 +165,7 @@ struct LetterAnalysis {
 
 /// Syllable-level analysis results
 struct SyllableAnalysis {
-    std::vector<std::string> all_syllables;  // Unique syllables found
+    StringTable all_syllables;  // Unique syllables found, in first-seen order
     FrequencyMap syllable_frequencies;
     PositionalFrequencies positional_syllables;
     std::map<int, MarkovChain> syllable_markov; // order -> chain
@@ -85,6 +178,16 @@ struct ComponentAnalysis {
     PositionalFrequencies positional_codas;
 };
 
+/// Resources used by one stage of a run (--profile-stages)
+struct StageTiming {
+    std::string stage;
+    double wall_seconds = 0.0;
+    std::optional<double> cpu_seconds{}; // Process-wide; absent for parts of the analysis pass
+    std::size_t allocations = 0;     // operator new calls; direct malloc calls are not seen
+    std::size_t allocated_bytes = 0; // Bytes asked of operator new
+    std::optional<long> peak_rss_kb{};   // Process-wide; absent for parts of the analysis pass
+};
+
 /// Overall statistics
 struct CorpusStats {
     std::size_t total_words = 0;
@@ -93,10 +196,18 @@ struct CorpusStats {
     double avg_word_length = 0.0;
     double avg_syllables_per_word = 0.0;
     std::map<std::size_t, std::size_t> length_distribution; // word_length -> count
+    std::size_t prune_error_bound = 0;   // Most that lossy counting overcounts any entry
+    std::vector<StageTiming> timings;    // Only with --embed-timings
 };
 
 /// Complete analysis results
 struct AnalysisResults {
+    /// Text of every key below. Copies of the results share it, and
+    /// merge_results() keeps the pools of the results merged in, so the
+    /// keys stay valid for as long as any results holding them.
+    std::shared_ptr<StringPool> strings = std::make_shared<StringPool>();
+    std::vector<std::shared_ptr<const StringPool>> merged_strings;
+
     Config config;
     CorpusStats stats;
     LetterAnalysis letter_analysis;
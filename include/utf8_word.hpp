@@ -0,0 +1,43 @@
+#pragma once
+
+#include "small_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace nameanalyzer {
+
+/// A word decoded once into codepoints, shared by every analysis stage.
+/// Invalid bytes are skipped and absorbed into the span of the following
+/// codepoint, which then decodes as -1 (the same convention utf8proc uses).
+///
+/// Both arrays live inline for words of up to inline_size codepoints, so
+/// decoding a typical name allocates nothing, even into a fresh Utf8Word.
+struct Utf8Word {
+    static constexpr std::size_t inline_size = 32;
+
+    std::string_view text;
+    SmallBuffer<std::int32_t, inline_size> codepoints;          // codepoints[i] = i-th codepoint
+    SmallBuffer<std::uint32_t, inline_size + 1> byte_positions;  // byte_positions[i] = byte offset of
+                                                                 // i-th codepoint, plus an end sentinel
+
+    std::size_t size() const { return codepoints.size(); }
+
+    /// Bytes of codepoints [first, last)
+    std::string_view slice(std::size_t first, std::size_t last) const {
+        return text.substr(byte_positions[first], byte_positions[last] - byte_positions[first]);
+    }
+
+    /// Undecodable bytes after the last codepoint (empty for valid UTF-8)
+    std::string_view trailing_bytes() const {
+        return text.substr(byte_positions.back());
+    }
+};
+
+/// Decode text into word, reusing word's buffers. ASCII text, checked 16
+/// bytes at a time, is widened directly without going through utf8proc.
+/// word.text views text, so text must outlive any use of word.
+/// Throws std::runtime_error for text of 4 GiB or more.
+void decode_utf8(std::string_view text, Utf8Word& word);
+
+} // namespace nameanalyzer
@@ -1,16 +1,169 @@
 #pragma once
 
+#include "case_fold.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <string>
 #include <string_view>
 
 namespace nameanalyzer {
 
+/// Case folding and filtering applied to every input word, whether it
+/// comes from a file or from memory
+class WordFilter {
+public:
+    enum class Verdict {
+        Accepted,
+        TooShort,
+        BadCharacters,  // Contains punctuation such as '(' or '-'
+    };
+
+    explicit WordFilter(int min_length = 2) : min_length_(min_length) {}
+
+    /// Case-fold token and check it. word is set to the folded token, which
+    /// views token itself or an internal buffer valid until the next call.
+    /// Throws std::runtime_error on invalid UTF-8.
+    Verdict filter(std::string_view token, std::string_view& word);
+
+private:
+    CaseFolder folder_;
+    std::string folded_;  // Scratch space for words changed by folding
+    int min_length_;
+};
+
+/// Streams words from a memory-mapped UTF-8 text file, so a corpus can be
+/// analyzed without copying all of it. Lines are comment-stripped ('#'),
+/// case-folded, split on whitespace and filtered exactly as read_words does.
+///
+/// A weighted file (--weighted) is a frequency list instead: each line
+/// holds one word and the number of times it occurred, separated by
+/// whitespace ("word<TAB>count"). Lines with a count of 0 are skipped.
+///
+/// With threads > 1, the file is parsed a block at a time: each block is
+/// cut into one range per thread at line boundaries, and every range is
+/// tokenized, folded and filtered on its own thread into its own words.
+/// The words, their order and the "Skipping" messages are the same as
+/// with one thread.
+class WordReader {
+public:
+    WordReader(std::string_view filename, int min_length = 2, bool weighted = false, int threads = 1);
+
+    /// Zero-copy access to the next word. The view points into the mapped
+    /// file, or into an internal buffer when case folding changed the word
+    /// or the file is parsed on several threads; either way it stays valid
+    /// until the next call. weight receives the word's count, which is 1
+    /// unless the file is weighted.
+    /// Returns false at end of input. Throws std::runtime_error on invalid
+    /// UTF-8 and on a weighted line without a valid count.
+    bool next_word(std::string_view& word, std::size_t& weight);
+    bool next_word(std::string_view& word);
+
+    /// Replace batch with up to max_words further words, and weights with
+    /// their counts. Returns false when no words were left.
+    bool next_batch(std::vector<std::string>& batch, std::vector<std::size_t>& weights,
+                    std::size_t max_words);
+    bool next_batch(std::vector<std::string>& batch, std::size_t max_words);
+
+    /// Total words handed out so far
+    std::size_t words_read() const { return words_read_; }
+
+    /// Sum of their weights
+    std::size_t occurrences_read() const { return occurrences_read_; }
+
+private:
+    /// Tokenizes, folds and filters the lines of one part of the file
+    class Scanner {
+    public:
+        Scanner(int min_length, bool weighted) : filter_(min_length), weighted_(weighted) {}
+
+        /// Start on text, which must begin at a line boundary
+        void reset(std::string_view text);
+
+        /// Next accepted word, as for next_word(). Rejected words with bad
+        /// characters are noted in skipped. Errors are thrown without
+        /// their location; lines() is the line they occurred on.
+        bool next(std::string_view& word, std::size_t& weight, std::string& skipped);
+
+        /// Lines started so far
+        std::size_t lines() const { return lines_; }
+
+    private:
+        std::string_view text_;
+        std::size_t next_line_ = 0;  // Offset of the first unread line in text_
+        std::string_view line_;      // Untokenized rest of the current line
+        std::size_t lines_ = 0;
+        WordFilter filter_;
+        bool weighted_;
+    };
+
+    /// One thread's range of the current block, parsed ahead
+    struct Part {
+        explicit Part(Scanner scanner) : scanner(std::move(scanner)) {}
+
+        Scanner scanner;
+        std::vector<std::string> words;  // The first count are this block's
+        std::vector<std::size_t> weights;
+        std::size_t count = 0;
+        std::string skipped;
+        std::exception_ptr failure;
+    };
+
+    bool next_batch(std::vector<std::string>& batch, std::vector<std::size_t>* weights,
+                    std::size_t max_words);
+
+    /// Parse the next block on every thread; false at end of input
+    bool parse_block();
+
+    /// Print the words skipped before the next word
+    void report_skipped(std::string& skipped);
+
+    /// Rethrow an error of the scanner, adding where it occurred
+    [[noreturn]] void rethrow_at(std::size_t line) const;
+
+    std::string filename_;
+    MappedFile file_;
+    Scanner scanner_;            // With one thread
+    std::string skipped_;
+    std::vector<Part> parts_;    // With several, one per thread
+    std::size_t next_block_ = 0; // Byte offset of the first unparsed line
+    std::size_t lines_before_ = 0;  // Lines of the blocks parsed before
+    std::size_t part_ = 0;       // Next word to hand out, by part and index
+    std::size_t index_ = 0;
+    std::size_t words_read_ = 0;
+    std::size_t occurrences_read_ = 0;
+};
+
+/// Collapses repeated words into one entry per distinct word, weighted by
+/// the sum of their weights (--dedupe). Words keep the order of their
+/// first occurrence, so analyzing the entries gives the same profile as
+/// analyzing every word, while the work grows with the vocabulary rather
+/// than with the number of tokens.
+class WordTally {
+public:
+    void add(std::string_view word, std::size_t weight = 1);
+
+    /// Distinct words so far
+    std::size_t size() const { return words_.size(); }
+
+    /// Hand over the distinct words and their weights, leaving the tally empty
+    void take(std::vector<std::string>& words, std::vector<std::size_t>& weights);
+
+private:
+    std::deque<std::string> words_;  // Never moved, so index_ can view them
+    std::vector<std::size_t> weights_;
+    std::unordered_map<std::string_view, std::size_t> index_;
+};
+
 /// Read words from a UTF-8 text file (one word per line)
 /// Returns vector of lowercase words, filtered by minimum length
 std::vector<std::string> read_words(std::string_view filename, int min_length = 2);
 
-/// Convert string to lowercase (ASCII only for simplicity)
+/// Convert string to lowercase using Unicode case folding
 std::string to_lowercase(std::string_view str);
 
 } // namespace nameanalyzer
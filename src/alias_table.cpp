@@ -0,0 +1,62 @@
+#include "alias_table.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+AliasTable::AliasTable(const std::vector<std::size_t>& weights) {
+    std::size_t total = 0;
+    for (std::size_t weight : weights) {
+        total += weight;
+    }
+    if (total == 0) {
+        throw std::invalid_argument("Alias table needs at least one positive weight");
+    }
+
+    std::size_t n = weights.size();
+    probabilities_.resize(n);
+    thresholds_.resize(n);
+    aliases_.resize(n);
+
+    // Scale so that the average column holds exactly 1, then let each
+    // underfull column borrow the rest of its height from an overfull one
+    std::vector<double> scaled(n);
+    std::vector<std::uint32_t> small;
+    std::vector<std::uint32_t> large;
+    for (std::size_t i = 0; i < n; ++i) {
+        probabilities_[i] = static_cast<double>(weights[i]) / static_cast<double>(total);
+        scaled[i] = probabilities_[i] * static_cast<double>(n);
+        aliases_[i] = static_cast<std::uint32_t>(i);
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        std::uint32_t under = small.back();
+        small.pop_back();
+        std::uint32_t over = large.back();
+
+        thresholds_[under] = scaled[under];
+        aliases_[under] = over;
+        scaled[over] -= 1.0 - scaled[under];
+        if (scaled[over] < 1.0) {
+            large.pop_back();
+            small.push_back(over);
+        }
+    }
+
+    // Whatever is left is full up to rounding error
+    for (std::uint32_t i : large) {
+        thresholds_[i] = 1.0;
+    }
+    for (std::uint32_t i : small) {
+        thresholds_[i] = 1.0;
+    }
+}
+
+std::size_t AliasTable::sample(double uniform) const {
+    double scaled = uniform * static_cast<double>(size());
+    auto column = std::min(static_cast<std::size_t>(scaled), size() - 1);
+    return sample(column, scaled - static_cast<double>(column));
+}
+
+} // namespace nameanalyzer
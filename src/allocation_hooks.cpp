@@ -0,0 +1,112 @@
+// Replacement global allocation functions, so that --profile-stages can
+// count allocations. Linked into the executables only: a library must not
+// replace operator new for the programs that use it. Every form of
+// operator new is counted, aligned ones included; memory that C code such
+// as utf8proc takes straight from malloc is not.
+
+#include "stage_profiler.hpp"
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace {
+
+void* counted_allocation(std::size_t size) {
+    nameanalyzer::count_allocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_aligned_allocation(std::size_t size, std::align_val_t alignment) {
+    nameanalyzer::count_allocation(size);
+    auto align = static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+    return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    // aligned_alloc wants a whole number of alignments
+    std::size_t rounded = (size == 0 ? 1 : size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded);
+#endif
+}
+
+void aligned_free(void* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (void* p = counted_allocation(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocation(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocation(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = counted_aligned_allocation(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_aligned_allocation(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_aligned_allocation(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    aligned_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    aligned_free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    aligned_free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    aligned_free(p);
+}
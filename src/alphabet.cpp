@@ -0,0 +1,47 @@
+#include "alphabet.hpp"
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+// 64-bit FNV-1a
+static std::uint64_t hash_symbol(std::string_view symbol) {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char c : symbol) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+Alphabet::Alphabet() : strings_(std::make_shared<StringPool>()) {
+    ascii_codes_.fill(unassigned);
+}
+
+std::uint32_t Alphabet::encode(std::string_view symbol) {
+    bool ascii = symbol.size() == 1 && static_cast<unsigned char>(symbol[0]) < 0x80;
+    if (ascii && ascii_codes_[static_cast<unsigned char>(symbol[0])] != unassigned) {
+        return ascii_codes_[static_cast<unsigned char>(symbol[0])];
+    }
+
+    std::size_t code = symbols_.intern(symbol, *strings_);
+    if (code >= max_size) {
+        throw std::runtime_error("Too many distinct characters in corpus (limit " +
+                                 std::to_string(max_size) + ")");
+    }
+    if (code == hashes_.size()) {
+        hashes_.push_back(hash_symbol(symbol));
+    }
+
+    if (ascii) {
+        ascii_codes_[static_cast<unsigned char>(symbol[0])] = static_cast<std::uint32_t>(code);
+    }
+    return static_cast<std::uint32_t>(code);
+}
+
+void Alphabet::encode_word(const Utf8Word& word, std::vector<std::uint32_t>& codes) {
+    codes.resize(word.size());
+    for (std::size_t i = 0; i < word.size(); ++i) {
+        codes[i] = encode(word.slice(i, i + 1));
+    }
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,110 @@
+#include "analysis_merge.hpp"
+#include <algorithm>
+
+namespace nameanalyzer {
+
+void merge_frequencies(FrequencyMap& dst, FrequencyMap&& src, std::size_t floor) {
+    if (floor > 0) {
+        for (auto& [key, count] : src) {
+            if (!dst.contains(key)) {
+                count += floor;
+            }
+        }
+    }
+    // Splice over every key dst lacks; what stays behind in src is a duplicate
+    dst.merge(src);
+    for (const auto& [key, count] : src) {
+        dst[key] += count;
+    }
+}
+
+void merge_positional(PositionalFrequencies& dst, PositionalFrequencies&& src, std::size_t floor) {
+    merge_frequencies(dst.start, std::move(src.start), floor);
+    merge_frequencies(dst.middle, std::move(src.middle), floor);
+    merge_frequencies(dst.end, std::move(src.end), floor);
+}
+
+void merge_markov_chain(MarkovChain& dst, MarkovChain&& src) {
+    dst.merge(src);
+    for (auto& [context, next_map] : src) {
+        merge_frequencies(dst[context], std::move(next_map));
+    }
+}
+
+void merge_markov_chains(std::map<int, MarkovChain>& dst, std::map<int, MarkovChain>&& src) {
+    for (auto& [order, chain] : src) {
+        merge_markov_chain(dst[order], std::move(chain));
+    }
+}
+
+void merge_letter_analysis(LetterAnalysis& dst, LetterAnalysis&& src) {
+    merge_frequencies(dst.unigrams, std::move(src.unigrams));
+    merge_frequencies(dst.bigrams, std::move(src.bigrams));
+    merge_frequencies(dst.trigrams, std::move(src.trigrams));
+    merge_frequencies(dst.fourgrams, std::move(src.fourgrams));
+    merge_positional(dst.positional_bigrams, std::move(src.positional_bigrams));
+    merge_positional(dst.positional_trigrams, std::move(src.positional_trigrams));
+    merge_markov_chains(dst.markov_chains, std::move(src.markov_chains));
+}
+
+void merge_component_analysis(ComponentAnalysis& dst, ComponentAnalysis&& src, std::size_t floor) {
+    merge_frequencies(dst.frequencies.onsets, std::move(src.frequencies.onsets), floor);
+    merge_frequencies(dst.frequencies.nuclei, std::move(src.frequencies.nuclei), floor);
+    merge_frequencies(dst.frequencies.codas, std::move(src.frequencies.codas), floor);
+    merge_positional(dst.positional_onsets, std::move(src.positional_onsets), floor);
+    merge_positional(dst.positional_codas, std::move(src.positional_codas), floor);
+}
+
+void merge_stats(CorpusStats& dst, const CorpusStats& src) {
+    dst.total_words += src.total_words;
+    dst.total_characters += src.total_characters;
+    dst.total_syllables += src.total_syllables;
+    dst.prune_error_bound += src.prune_error_bound;
+    for (const auto& [length, count] : src.length_distribution) {
+        dst.length_distribution[length] += count;
+    }
+}
+
+void update_derived_stats(CorpusStats& stats) {
+    if (stats.total_words == 0) {
+        stats.avg_word_length = 0.0;
+        stats.avg_syllables_per_word = 0.0;
+        return;
+    }
+    double words = static_cast<double>(stats.total_words);
+    stats.avg_word_length = static_cast<double>(stats.total_characters) / words;
+    stats.avg_syllables_per_word = static_cast<double>(stats.total_syllables) / words;
+}
+
+void merge_syllable_analysis(SyllableAnalysis& dst, SyllableAnalysis&& src, std::size_t floor) {
+    for (const auto& syll : src.all_syllables) {
+        dst.all_syllables.intern(syll);
+    }
+    merge_frequencies(dst.syllable_frequencies, std::move(src.syllable_frequencies), floor);
+    merge_positional(dst.positional_syllables, std::move(src.positional_syllables), floor);
+    merge_markov_chains(dst.syllable_markov, std::move(src.syllable_markov));
+}
+
+void keep_strings(AnalysisResults& dst, const AnalysisResults& src) {
+    auto keep = [&dst](const std::shared_ptr<const StringPool>& strings) {
+        if (strings && strings != dst.strings &&
+            std::find(dst.merged_strings.begin(), dst.merged_strings.end(), strings) == dst.merged_strings.end()) {
+            dst.merged_strings.push_back(strings);
+        }
+    };
+    keep(src.strings);
+    for (const auto& strings : src.merged_strings) {
+        keep(strings);
+    }
+}
+
+void merge_results(AnalysisResults& dst, AnalysisResults&& src) {
+    keep_strings(dst, src);
+    merge_stats(dst.stats, src.stats);
+    merge_letter_analysis(dst.letter_analysis, std::move(src.letter_analysis));
+    merge_syllable_analysis(dst.syllable_analysis, std::move(src.syllable_analysis));
+    merge_component_analysis(dst.component_analysis, std::move(src.component_analysis));
+    update_derived_stats(dst.stats);
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,143 @@
+#include "analyzer.hpp"
+#include "analysis_merge.hpp"
+#include "pruning.hpp"
+#include "approximate_counter.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace nameanalyzer {
+
+void keep_strongest_pruning(Config& config, const Config& other) {
+    config.min_count = std::max(config.min_count, other.min_count);
+    if (other.top_k_per_context > 0 &&
+        (config.top_k_per_context == 0 || other.top_k_per_context < config.top_k_per_context)) {
+        config.top_k_per_context = other.top_k_per_context;
+    }
+    config.approximate_epsilon = std::max(config.approximate_epsilon, other.approximate_epsilon);
+    config.prune_epsilon = std::max(config.prune_epsilon, other.prune_epsilon);
+}
+
+Config continued_config(const Config& profile, Config config) {
+    config.markov_order = profile.markov_order;
+    config.min_word_length = profile.min_word_length;
+    config.enable_syllables = profile.enable_syllables;
+    config.enable_components = profile.enable_components;
+    config.phonemes = profile.phonemes;
+    keep_strongest_pruning(config, profile);
+    config.sampling_tables = config.sampling_tables || profile.sampling_tables;
+    if (!profile.input_file.empty()) {
+        config.input_file = config.input_file.empty() ? profile.input_file
+                                                      : profile.input_file + "," + config.input_file;
+    }
+    return config;
+}
+
+namespace {
+
+// Reject settings the analysis cannot honour, before anything is sized by them
+const Config& checked(const Config& config) {
+    if (config.markov_order < 1 || config.markov_order > max_markov_order) {
+        throw std::runtime_error("Markov order must be from 1 to " + std::to_string(max_markov_order));
+    }
+    if (config.approximate_epsilon != 0.0 &&
+        !(config.approximate_epsilon >= min_approximate_epsilon && config.approximate_epsilon < 1.0)) {
+        std::ostringstream message;
+        message << "Approximation error must be 0, or at least " << min_approximate_epsilon << " and below 1";
+        throw std::runtime_error(message.str());
+    }
+    if (config.prune_epsilon != 0.0 && !(config.prune_epsilon > 0.0 && config.prune_epsilon < 1.0)) {
+        throw std::runtime_error("Pruning error must be 0, or between 0 and 1");
+    }
+    return config;
+}
+
+} // namespace
+
+Analyzer::Analyzer(const Config& config)
+    : config_(checked(config)), analyzer_(config_), filter_(config_.min_word_length) {
+}
+
+Analyzer::Analyzer(AnalysisResults profile, const Config& config)
+    : config_(checked(continued_config(profile.config, config))), analyzer_(config_),
+      filter_(config_.min_word_length), profile_(std::move(profile)) {
+}
+
+bool Analyzer::add(std::string_view word) {
+    return add(word, 1);
+}
+
+bool Analyzer::add(std::string_view word, std::size_t weight) {
+    std::string_view folded;
+    if (weight == 0 || filter_.filter(word, folded) != WordFilter::Verdict::Accepted) {
+        return false;
+    }
+    ++words_added_;
+
+    if (config_.threads <= 1) {
+        analyzer_.add_word(folded, weight);
+        return true;
+    }
+    pending_.emplace_back(folded);
+    pending_weights_.push_back(weight);
+    if (pending_.size() >= config_.batch_size) {
+        flush();
+    }
+    return true;
+}
+
+std::size_t Analyzer::add(std::span<const std::string> words) {
+    return add(words.begin(), words.end());
+}
+
+std::size_t Analyzer::add(std::span<const std::string_view> words) {
+    return add(words.begin(), words.end());
+}
+
+void Analyzer::add_prepared(std::span<const std::string> words, std::span<const std::size_t> weights) {
+    flush();
+    analyzer_.add_words(words, weights);
+    words_added_ += words.size();
+}
+
+void Analyzer::flush() {
+    if (!pending_.empty()) {
+        analyzer_.add_words(pending_, pending_weights_);
+        pending_.clear();
+        pending_weights_.clear();
+    }
+}
+
+AnalysisResults Analyzer::results() const {
+    CorpusAnalyzer snapshot = analyzer_;
+    snapshot.add_words(pending_, pending_weights_);
+    AnalysisResults results = snapshot.finish();
+    if (!profile_) {
+        return results;
+    }
+    AnalysisResults merged = *profile_;
+    merge_results(merged, std::move(results));
+    merged.config = config_;
+    prune_results(merged);
+    return merged;
+}
+
+AnalysisResults Analyzer::finish() {
+    flush();
+    AnalysisResults results = analyzer_.finish();
+    analyzer_ = CorpusAnalyzer(config_);
+    words_added_ = 0;
+    if (!profile_) {
+        return results;
+    }
+    AnalysisResults merged = std::move(*profile_);
+    profile_.reset();
+    merge_results(merged, std::move(results));
+    merged.config = config_;
+    prune_results(merged);
+    return merged;
+}
+
+} // namespace nameanalyzer
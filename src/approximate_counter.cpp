@@ -0,0 +1,154 @@
+#include "approximate_counter.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace nameanalyzer {
+
+CountMinSketch::CountMinSketch(double epsilon, double delta) {
+    // width e / epsilon bounds the error, ln(1 / delta) rows its probability
+    auto min_width = static_cast<std::size_t>(std::ceil(std::exp(1.0) / epsilon));
+    width_ = 1;
+    shift_ = 64;
+    while (width_ < min_width) {
+        width_ *= 2;
+        --shift_;
+    }
+    depth_ = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::log(1.0 / delta))));
+    counters_.assign(width_ * depth_, 0);
+}
+
+std::size_t CountMinSketch::cell(std::size_t row, std::uint64_t key) const {
+    // A different odd multiplier per row; the top bits are the best mixed
+    std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL + 2 * 0x632BE59BD9B4E019ULL * row;
+    std::uint64_t slot = width_ == 1 ? 0 : (key * multiplier) >> shift_;
+    return row * width_ + static_cast<std::size_t>(slot);
+}
+
+std::size_t CountMinSketch::add(std::uint64_t key, std::size_t count) {
+    // Conservative update: raise only the counters that would otherwise
+    // fall below the new estimate, which keeps the others tighter
+    std::size_t target = estimate(key) + count;
+    for (std::size_t row = 0; row < depth_; ++row) {
+        std::size_t& counter = counters_[cell(row, key)];
+        counter = std::max(counter, target);
+    }
+    return target;
+}
+
+std::size_t CountMinSketch::estimate(std::uint64_t key) const {
+    std::size_t best = counters_[cell(0, key)];
+    for (std::size_t row = 1; row < depth_; ++row) {
+        best = std::min(best, counters_[cell(row, key)]);
+    }
+    return best;
+}
+
+void CountMinSketch::clear() {
+    std::fill(counters_.begin(), counters_.end(), 0);
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    for (std::size_t i = 0; i < counters_.size(); ++i) {
+        counters_[i] += other.counters_[i];
+    }
+}
+
+ApproximateCounter::ApproximateCounter(double epsilon, double delta)
+    : sketch_(epsilon, delta),
+      capacity_(std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(2.0 / epsilon)))) {
+}
+
+void ApproximateCounter::clear() {
+    sketch_.clear();
+    heap_.clear();
+    slots_.clear();
+}
+
+void ApproximateCounter::add(std::uint64_t hash, std::uint64_t item, std::size_t weight) {
+    std::size_t count = sketch_.add(hash, weight);
+
+    auto found = slots_.find(hash);
+    if (found != slots_.end()) {
+        // Estimates only grow, so a kept key can only move away from the root
+        heap_[found->second].count = count;
+        sift_down(found->second);
+        return;
+    }
+
+    Entry entry{count, hash, item};
+    if (heap_.size() < capacity_) {
+        heap_.push_back(entry);
+        slots_[hash] = heap_.size() - 1;
+        sift_up(heap_.size() - 1);
+    } else if (lower(heap_.front(), entry)) {
+        slots_.erase(heap_.front().hash);
+        place(0, entry);
+        sift_down(0);
+    }
+}
+
+void ApproximateCounter::place(std::size_t pos, const Entry& entry) {
+    heap_[pos] = entry;
+    slots_[entry.hash] = pos;
+}
+
+void ApproximateCounter::sift_up(std::size_t pos) {
+    Entry entry = heap_[pos];
+    while (pos > 0) {
+        std::size_t parent = (pos - 1) / 2;
+        if (!lower(entry, heap_[parent])) {
+            break;
+        }
+        place(pos, heap_[parent]);
+        pos = parent;
+    }
+    place(pos, entry);
+}
+
+void ApproximateCounter::sift_down(std::size_t pos) {
+    Entry entry = heap_[pos];
+    while (true) {
+        std::size_t child = 2 * pos + 1;
+        if (child >= heap_.size()) {
+            break;
+        }
+        if (child + 1 < heap_.size() && lower(heap_[child + 1], heap_[child])) {
+            ++child;
+        }
+        if (!lower(heap_[child], entry)) {
+            break;
+        }
+        place(pos, heap_[child]);
+        pos = child;
+    }
+    place(pos, entry);
+}
+
+void ApproximateCounter::rebuild(std::vector<Entry> candidates) {
+    // Keep the first of any duplicates: that is this counter's own item
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+    candidates.erase(std::unique(candidates.begin(), candidates.end(),
+                                 [](const Entry& a, const Entry& b) { return a.hash == b.hash; }),
+                     candidates.end());
+    for (Entry& entry : candidates) {
+        entry.count = sketch_.estimate(entry.hash);
+    }
+
+    // Highest estimates first
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Entry& a, const Entry& b) { return lower(b, a); });
+    if (candidates.size() > capacity_) {
+        candidates.resize(capacity_);
+    }
+    // Sorted descending, so reversed it is already a valid min-heap
+    std::reverse(candidates.begin(), candidates.end());
+
+    heap_ = std::move(candidates);
+    slots_.clear();
+    for (std::size_t i = 0; i < heap_.size(); ++i) {
+        slots_[heap_[i].hash] = i;
+    }
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,101 @@
+#include "case_fold.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <utf8proc.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nameanalyzer {
+
+bool is_ascii(std::string_view str) {
+    const char* data = str.data();
+    std::size_t size = str.size();
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    // movemask gathers the top bit of each of the 16 bytes
+    __m128i high_bits = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        high_bits = _mm_or_si128(high_bits,
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    }
+    if (_mm_movemask_epi8(high_bits) != 0) {
+        return false;
+    }
+#else
+    // Eight bytes at a time
+    std::uint64_t high_bits = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, data + i, sizeof(chunk));
+        high_bits |= chunk;
+    }
+    if (high_bits & 0x8080808080808080ULL) {
+        return false;
+    }
+#endif
+
+    unsigned char tail = 0;
+    for (; i < size; ++i) {
+        tail |= static_cast<unsigned char>(data[i]);
+    }
+    return tail < 0x80;
+}
+
+// For ASCII, case folding is plain A-Z lowering and NFC changes nothing
+static void fold_ascii(char* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        data[i] = static_cast<char>(c + (static_cast<unsigned char>(c - 'A') < 26 ? 'a' - 'A' : 0));
+    }
+}
+
+void CaseFolder::fold(std::string_view str, std::string& out) {
+    str = str.substr(0, str.find('\0'));
+
+    if (is_ascii(str)) {
+        out.assign(str);
+        fold_ascii(out.data(), out.size());
+        return;
+    }
+
+    // Same steps as utf8proc_map, but into a reusable buffer: decompose
+    // (growing the buffer if it was too small), then compose and re-encode
+    // as UTF-8 in place. Re-encoding needs one spare slot for its NUL.
+    const auto options = static_cast<utf8proc_option_t>(UTF8PROC_STABLE | UTF8PROC_COMPOSE | UTF8PROC_CASEFOLD);
+    const auto* bytes = reinterpret_cast<const utf8proc_uint8_t*>(str.data());
+    const auto length = static_cast<utf8proc_ssize_t>(str.size());
+
+    if (codepoints_.size() < str.size() + 1) {
+        codepoints_.resize(str.size() + 1);
+    }
+    utf8proc_ssize_t count = utf8proc_decompose(bytes, length, codepoints_.data(),
+        static_cast<utf8proc_ssize_t>(codepoints_.size()) - 1, options);
+    if (count >= 0 && static_cast<std::size_t>(count) + 1 > codepoints_.size()) {
+        codepoints_.resize(static_cast<std::size_t>(count) + 1);
+        count = utf8proc_decompose(bytes, length, codepoints_.data(), count, options);
+    }
+    if (count < 0) {
+        throw std::runtime_error("UTF-8 case conversion failed for: " + std::string(str));
+    }
+
+    utf8proc_ssize_t encoded = utf8proc_reencode(codepoints_.data(), count, options);
+    if (encoded < 0) {
+        throw std::runtime_error("UTF-8 case conversion failed for: " + std::string(str));
+    }
+    out.assign(reinterpret_cast<const char*>(codepoints_.data()), static_cast<std::size_t>(encoded));
+}
+
+void CaseFolder::fold_in_place(std::string& str) {
+    if (is_ascii(str) && str.find('\0') == std::string::npos) {
+        fold_ascii(str.data(), str.size());
+        return;
+    }
+
+    // The non-ASCII result is assembled in codepoints_, so str can be the target
+    fold(std::string_view(str), str);
+}
+
+} // namespace nameanalyzer
@@ -1,23 +1,67 @@
 #include "cli_parser.hpp"
+#include "approximate_counter.hpp"
 #include <iostream>
 #include <algorithm>
 #include <string_view>
+#include <thread>
 
 namespace nameanalyzer {
 
+// Parse the value of a count option such as --min-count, which must be at
+// least 1; i is advanced past the value. Returns false after printing an error.
+static bool parse_count_option(std::string_view option, int argc, char* argv[], int& i, std::size_t& value) {
+    if (i + 1 >= argc) {
+        std::cerr << "Error: " << option << " requires an argument\n";
+        return false;
+    }
+    try {
+        long long count = std::stoll(argv[++i]);
+        if (count < 1) {
+            std::cerr << "Error: " << option << " must be at least 1\n";
+            return false;
+        }
+        value = static_cast<std::size_t>(count);
+        return true;
+    } catch (...) {
+        std::cerr << "Error: Invalid " << option.substr(2) << " value\n";
+        return false;
+    }
+}
+
 void print_usage(std::string_view program_name) {
     std::cout << "NameAnalyzer - Analyze words to extract statistical patterns\n\n"
-              << "Usage: " << program_name << " <input_file> -o <output_file> [options]\n\n"
+              << "Usage: " << program_name << " <input_file> -o <output_file> [options]\n"
+              << "       " << program_name << " merge <profile>... -o <output_file> [options]\n"
+              << "       " << program_name << " serve <profile> --socket <path> [options]\n\n"
               << "Required arguments:\n"
               << "  <input_file>              Input text file (one word per line, UTF-8)\n"
               << "  -o, --output <file>       Output JSON file for statistics\n\n"
               << "Options:\n"
+              << "  --binary <file>           Also write a memory-mappable binary profile\n"
+              << "  --update <profile>        Add the input words to an existing JSON profile\n"
               << "  --min-length <n>          Minimum word length to analyze (default: 2)\n"
+              << "  --threads <n>             Parsing and analysis threads, 0 = all cores (default: 1)\n"
+              << "  --batch-size <n>          Words read and analyzed per batch (default: 65536)\n"
+              << "  --weighted                Input lines are \"word<TAB>count\" frequency list entries\n"
+              << "  --dedupe                  Count repeated words once, weighted, before analysis\n"
+              << "  --min-count <n>           Drop n-grams, transitions and syllables seen fewer than n times\n"
+              << "  --top-k-per-context <k>   Keep the k most frequent Markov transitions per context\n"
+              << "  --approximate <epsilon>   Count 4-grams and top-order Markov transitions in fixed memory,\n"
+              << "                            overcounting by at most epsilon times the total (e.g. 0.0001)\n"
+              << "  --prune-epsilon <epsilon> Drop rare n-grams, transitions, syllables and components after\n"
+              << "                            every batch to bound memory, overcounting by at most epsilon\n"
+              << "                            times the words\n"
+              << "  --sampling-tables         Add per-context probabilities and alias tables for sampling\n"
+              << "  --phonemes <file>         Syllabify with the vowels, glides and onsets listed in file\n"
+              << "  --compact                 Write JSON without indentation or line breaks\n"
+              << "  --profile-stages <file>   Write time and memory used per stage to a JSON file\n"
+              << "  --embed-timings           Add the per-stage measurements to the output as stats.timings\n"
               << "  -v, --verbose             Verbose output\n"
               << "  -h, --help                Show this help message\n\n"
               << "Examples:\n"
               << "  " << program_name << " words.txt -o output.json\n"
-              << "  " << program_name << " greek_names.txt -o greek.json\n";
+              << "  " << program_name << " greek_names.txt -o greek.json\n"
+              << "  " << program_name << " new_greek_names.txt --update greek.json -o greek.json\n";
 }
 
 std::optional<Config> parse_arguments(int argc, char* argv[]) {
@@ -45,6 +89,20 @@ std::optional<Config> parse_arguments(int argc, char* argv[]) {
             config.output_file = argv[++i];
             has_output = true;
         }
+        else if (arg == "--binary") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --binary requires an argument\n";
+                return std::nullopt;
+            }
+            config.binary_output_file = argv[++i];
+        }
+        else if (arg == "--update") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --update requires an argument\n";
+                return std::nullopt;
+            }
+            config.update_profile = argv[++i];
+        }
         else if (arg == "--min-length") {
             if (i + 1 >= argc) {
                 std::cerr << "Error: --min-length requires an argument\n";
@@ -62,6 +120,119 @@ std::optional<Config> parse_arguments(int argc, char* argv[]) {
                 return std::nullopt;
             }
         }
+        else if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --threads requires an argument\n";
+                return std::nullopt;
+            }
+            try {
+                int threads = std::stoi(argv[++i]);
+                if (threads < 0) {
+                    std::cerr << "Error: Thread count must not be negative\n";
+                    return std::nullopt;
+                }
+                if (threads == 0) {
+                    threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+                }
+                config.threads = threads;
+            } catch (...) {
+                std::cerr << "Error: Invalid threads value\n";
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--batch-size") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --batch-size requires an argument\n";
+                return std::nullopt;
+            }
+            try {
+                long long size = std::stoll(argv[++i]);
+                if (size < 1) {
+                    std::cerr << "Error: Batch size must be at least 1\n";
+                    return std::nullopt;
+                }
+                config.batch_size = static_cast<std::size_t>(size);
+            } catch (...) {
+                std::cerr << "Error: Invalid batch-size value\n";
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--weighted") {
+            config.weighted_input = true;
+        }
+        else if (arg == "--dedupe") {
+            config.dedupe = true;
+        }
+        else if (arg == "--min-count") {
+            if (!parse_count_option(arg, argc, argv, i, config.min_count)) {
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--top-k-per-context") {
+            if (!parse_count_option(arg, argc, argv, i, config.top_k_per_context)) {
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--approximate") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --approximate requires an argument\n";
+                return std::nullopt;
+            }
+            try {
+                double epsilon = std::stod(argv[++i]);
+                if (!(epsilon >= min_approximate_epsilon && epsilon < 1.0)) {
+                    std::cerr << "Error: Approximation error must be at least " << min_approximate_epsilon
+                              << " and below 1\n";
+                    return std::nullopt;
+                }
+                config.approximate_epsilon = epsilon;
+            } catch (...) {
+                std::cerr << "Error: Invalid approximate value\n";
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--prune-epsilon") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --prune-epsilon requires an argument\n";
+                return std::nullopt;
+            }
+            try {
+                double epsilon = std::stod(argv[++i]);
+                if (!(epsilon > 0.0 && epsilon < 1.0)) {
+                    std::cerr << "Error: Pruning error must be between 0 and 1\n";
+                    return std::nullopt;
+                }
+                config.prune_epsilon = epsilon;
+            } catch (...) {
+                std::cerr << "Error: Invalid prune-epsilon value\n";
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--sampling-tables") {
+            config.sampling_tables = true;
+        }
+        else if (arg == "--phonemes") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --phonemes requires an argument\n";
+                return std::nullopt;
+            }
+            config.phonemes_file = argv[++i];
+        }
+        else if (arg == "--compact") {
+            config.compact_output = true;
+        }
+        else if (arg == "--profile-stages") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --profile-stages requires an argument\n";
+                return std::nullopt;
+            }
+            config.stage_profile_file = argv[++i];
+            config.profile_stages = true;
+        }
+        else if (arg == "--embed-timings") {
+            config.embed_timings = true;
+            config.profile_stages = true;
+        }
         else if (arg == "-v" || arg == "--verbose") {
             config.verbose = true;
         }
@@ -96,4 +267,189 @@ std::optional<Config> parse_arguments(int argc, char* argv[]) {
     return config;
 }
 
+void print_merge_usage(std::string_view program_name) {
+    std::cout << "NameAnalyzer merge - Combine profiles of parts of a corpus\n\n"
+              << "Usage: " << program_name << " merge <profile>... -o <output_file> [options]\n\n"
+              << "Sums every count of the input JSON profiles and recomputes the statistics.\n"
+              << "List the profiles in corpus order: new syllables are appended in that order.\n\n"
+              << "Required arguments:\n"
+              << "  <profile>...              JSON profiles written by nameanalyzer\n"
+              << "  -o, --output <file>       Output JSON file for the merged profile\n\n"
+              << "Options:\n"
+              << "  --binary <file>           Also write a memory-mappable binary profile\n"
+              << "  --min-count <n>           Drop n-grams, transitions and syllables seen fewer than n times\n"
+              << "  --top-k-per-context <k>   Keep the k most frequent Markov transitions per context\n"
+              << "  --sampling-tables         Add per-context probabilities and alias tables for sampling\n"
+              << "  --force                   Also merge profiles built with pruning or approximate counting,\n"
+              << "                            whose merged counts can differ from a single run\n"
+              << "  --compact                 Write JSON without indentation or line breaks\n"
+              << "  -v, --verbose             Verbose output\n"
+              << "  -h, --help                Show this help message\n\n"
+              << "Example:\n"
+              << "  " << program_name << " merge part1.json part2.json part3.json -o all.json\n";
+}
+
+std::optional<MergeConfig> parse_merge_arguments(int argc, char* argv[]) {
+    MergeConfig config;
+    bool has_output = false;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            print_merge_usage(argv[0]);
+            return std::nullopt;
+        }
+        else if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return std::nullopt;
+            }
+            config.output_file = argv[++i];
+            has_output = true;
+        }
+        else if (arg == "--binary") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --binary requires an argument\n";
+                return std::nullopt;
+            }
+            config.binary_output_file = argv[++i];
+        }
+        else if (arg == "--min-count") {
+            if (!parse_count_option(arg, argc, argv, i, config.min_count)) {
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--top-k-per-context") {
+            if (!parse_count_option(arg, argc, argv, i, config.top_k_per_context)) {
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--sampling-tables") {
+            config.sampling_tables = true;
+        }
+        else if (arg == "--force") {
+            config.force = true;
+        }
+        else if (arg == "--compact") {
+            config.compact_output = true;
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            config.verbose = true;
+        }
+        else if (arg[0] == '-') {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            return std::nullopt;
+        }
+        else {
+            config.input_files.emplace_back(arg);
+        }
+    }
+
+    if (config.input_files.empty()) {
+        std::cerr << "Error: No input profiles specified\n";
+        print_merge_usage(argv[0]);
+        return std::nullopt;
+    }
+
+    if (!has_output) {
+        std::cerr << "Error: No output file specified (use -o or --output)\n";
+        print_merge_usage(argv[0]);
+        return std::nullopt;
+    }
+
+    return config;
+}
+
+void print_serve_usage(std::string_view program_name) {
+    std::cout << "NameAnalyzer serve - Answer profile queries over a Unix domain socket\n\n"
+              << "Usage: " << program_name << " serve <profile> --socket <path> [options]\n"
+              << "       " << program_name << " serve --words <input_file> --socket <path> [options]\n\n"
+              << "Loads a JSON profile, or analyzes a word list with the default settings, indexes it\n"
+              << "and answers one response line per request line until interrupted:\n"
+              << "  next <context> [k]        Letters that follow a context such as ^^s, by count\n"
+              << "  snext <context> [k]       Syllables that follow a context such as ^|per\n"
+              << "  top <table> [k]           Most frequent entries of a table such as onsets.start\n"
+              << "  count <table> <key>       Count, table total and rank of one entry\n"
+              << "  stats                     Word, character and syllable totals\n"
+              << "  latency                   Query latency percentiles in microseconds\n"
+              << "  quit                      Close the connection\n\n"
+              << "Options:\n"
+              << "  --socket <path>           Socket to listen on (required)\n"
+              << "  --words <file>            Analyze this word list instead of loading a profile\n"
+              << "  --threads <n>             Threads for analyzing the word list, 0 = all cores\n"
+              << "  -v, --verbose             Verbose output\n"
+              << "  -h, --help                Show this help message\n\n"
+              << "Example:\n"
+              << "  " << program_name << " serve greek.json --socket /tmp/greek.sock\n";
+}
+
+std::optional<ServeConfig> parse_serve_arguments(int argc, char* argv[]) {
+    ServeConfig config;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            print_serve_usage(argv[0]);
+            return std::nullopt;
+        }
+        else if (arg == "--socket" || arg == "--words") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument\n";
+                return std::nullopt;
+            }
+            (arg == "--socket" ? config.socket_path : config.words_file) = argv[++i];
+        }
+        else if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --threads requires an argument\n";
+                return std::nullopt;
+            }
+            try {
+                int threads = std::stoi(argv[++i]);
+                if (threads < 0) {
+                    std::cerr << "Error: Thread count must not be negative\n";
+                    return std::nullopt;
+                }
+                if (threads == 0) {
+                    threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+                }
+                config.threads = threads;
+            } catch (...) {
+                std::cerr << "Error: Invalid threads value\n";
+                return std::nullopt;
+            }
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            config.verbose = true;
+        }
+        else if (arg[0] == '-') {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            return std::nullopt;
+        }
+        else if (config.profile_file.empty()) {
+            config.profile_file = arg;
+        }
+        else {
+            std::cerr << "Error: Multiple profiles specified\n";
+            return std::nullopt;
+        }
+    }
+
+    if (config.profile_file.empty() == config.words_file.empty()) {
+        std::cerr << "Error: Specify either a profile or --words <file>\n";
+        print_serve_usage(argv[0]);
+        return std::nullopt;
+    }
+
+    if (config.socket_path.empty()) {
+        std::cerr << "Error: No socket specified (use --socket)\n";
+        print_serve_usage(argv[0]);
+        return std::nullopt;
+    }
+
+    return config;
+}
+
 } // namespace nameanalyzer
@@ -3,38 +3,41 @@
 
 namespace nameanalyzer {
 
-ComponentAnalysis analyze_components(const std::vector<std::string>& words) {
+void accumulate_components(const std::vector<Syllable>& syllables, ComponentAnalysis& analysis,
+                           StringPool& strings, std::size_t weight, std::size_t floor) {
+    for (std::size_t i = 0; i < syllables.size(); ++i) {
+        const auto& syll = syllables[i];
+
+        // Count component frequencies
+        add_count(analysis.frequencies.onsets, strings, syll.onset, weight, floor);
+        add_count(analysis.frequencies.nuclei, strings, syll.nucleus, weight, floor);
+        add_count(analysis.frequencies.codas, strings, syll.coda, weight, floor);
+
+        // Positional onset frequencies
+        if (i == 0) {
+            add_count(analysis.positional_onsets.start, strings, syll.onset, weight, floor);
+        } else if (i == syllables.size() - 1) {
+            add_count(analysis.positional_onsets.end, strings, syll.onset, weight, floor);
+        } else {
+            add_count(analysis.positional_onsets.middle, strings, syll.onset, weight, floor);
+        }
+
+        // Positional coda frequencies
+        if (i == 0) {
+            add_count(analysis.positional_codas.start, strings, syll.coda, weight, floor);
+        } else if (i == syllables.size() - 1) {
+            add_count(analysis.positional_codas.end, strings, syll.coda, weight, floor);
+        } else {
+            add_count(analysis.positional_codas.middle, strings, syll.coda, weight, floor);
+        }
+    }
+}
+
+ComponentAnalysis analyze_components(const std::vector<std::string>& words, StringPool& strings) {
     ComponentAnalysis analysis;
 
     for (const auto& word : words) {
-        auto syllables = detect_syllables(word);
-
-        for (std::size_t i = 0; i < syllables.size(); ++i) {
-            const auto& syll = syllables[i];
-
-            // Count component frequencies
-            analysis.frequencies.onsets[syll.onset]++;
-            analysis.frequencies.nuclei[syll.nucleus]++;
-            analysis.frequencies.codas[syll.coda]++;
-
-            // Positional onset frequencies
-            if (i == 0) {
-                analysis.positional_onsets.start[syll.onset]++;
-            } else if (i == syllables.size() - 1) {
-                analysis.positional_onsets.end[syll.onset]++;
-            } else {
-                analysis.positional_onsets.middle[syll.onset]++;
-            }
-
-            // Positional coda frequencies
-            if (i == 0) {
-                analysis.positional_codas.start[syll.coda]++;
-            } else if (i == syllables.size() - 1) {
-                analysis.positional_codas.end[syll.coda]++;
-            } else {
-                analysis.positional_codas.middle[syll.coda]++;
-            }
-        }
+        accumulate_components(detect_syllables(word), analysis, strings);
     }
 
     return analysis;
@@ -0,0 +1,211 @@
+#include "context_trie.hpp"
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+namespace nameanalyzer {
+
+ContextTrie::ContextTrie(int max_order) : max_order_(max_order) {
+    nodes_.push_back({0, 0, 0});
+}
+
+std::uint32_t ContextTrie::child(std::uint32_t node, std::uint32_t symbol) {
+    // Node 0 is the root and never anyone's child, so 0 means "missing"
+    std::size_t& slot = children_[edge_key(node, symbol)];
+    if (slot == 0) {
+        slot = nodes_.size();
+        nodes_.push_back({node, symbol, nodes_[node].depth + 1});
+    }
+    return static_cast<std::uint32_t>(slot);
+}
+
+void ContextTrie::add_sequence(const std::vector<std::uint32_t>& symbols, std::uint32_t pad,
+                               std::uint32_t end, std::size_t weight) {
+    for (std::size_t j = 0; j <= symbols.size(); ++j) {
+        std::uint32_t next = j < symbols.size() ? symbols[j] : end;
+
+        // Extend the context one symbol further back per order
+        std::uint32_t node = 0;
+        for (int order = 1; order <= max_order_; ++order) {
+            std::size_t back = static_cast<std::size_t>(order);
+            node = child(node, j >= back ? symbols[j - back] : pad);
+            transitions_.add(edge_key(node, next), weight);
+        }
+    }
+}
+
+void ContextTrie::merge(const ContextTrie& src, const std::vector<std::uint32_t>& remap) {
+    // Parents precede their children in nodes_, so one forward pass can
+    // map every source node to its counterpart here
+    std::vector<std::uint32_t> node_map(src.nodes_.size(), 0);
+    for (std::size_t i = 1; i < src.nodes_.size(); ++i) {
+        const Node& node = src.nodes_[i];
+        node_map[i] = child(node_map[node.parent], remap[node.symbol]);
+    }
+
+    src.transitions_.for_each([&](std::uint64_t key, std::size_t count) {
+        auto node = static_cast<std::uint32_t>(key >> 32);
+        auto next = static_cast<std::uint32_t>(key & 0xFFFFFFFF);
+        transitions_.add(edge_key(node_map[node], remap[next]), count);
+    });
+}
+
+std::vector<InternedString> ContextTrie::context_texts(const StringTable& symbols, StringPool& strings,
+                                                      std::string_view separator) const {
+    // A context reads farthest symbol first, then its parent's context
+    std::vector<InternedString> texts(nodes_.size());
+    std::string text;
+    for (std::size_t i = 1; i < nodes_.size(); ++i) {
+        text = symbols[nodes_[i].symbol];
+        if (nodes_[i].parent != 0) {
+            text += separator;
+        }
+        text += texts[nodes_[i].parent];
+        texts[i] = strings.intern(text);
+    }
+    return texts;
+}
+
+void ContextTrie::prune(std::size_t threshold) {
+    transitions_.prune_lossy(threshold);
+
+    // A context stays while it or a longer one below it has transitions.
+    // Children follow their parents in nodes_, so one backward pass marks
+    // every ancestor of a live node.
+    std::vector<bool> live(nodes_.size(), false);
+    live[0] = true;
+    transitions_.for_each([&live](std::uint64_t key, std::size_t) { live[key >> 32] = true; });
+    std::size_t kept = 1;
+    for (std::size_t i = nodes_.size() - 1; i > 0; --i) {
+        if (live[i]) {
+            live[nodes_[i].parent] = true;
+            ++kept;
+        }
+    }
+    if (kept == nodes_.size()) {
+        return;
+    }
+
+    // Renumber the live nodes in order, so parents still precede children
+    std::vector<std::uint32_t> renumber(nodes_.size(), 0);
+    std::vector<Node> nodes;
+    nodes.reserve(kept);
+    nodes.push_back(nodes_[0]);
+    for (std::size_t i = 1; i < nodes_.size(); ++i) {
+        if (live[i]) {
+            renumber[i] = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back({renumber[nodes_[i].parent], nodes_[i].symbol, nodes_[i].depth});
+        }
+    }
+    nodes_ = std::move(nodes);
+
+    children_ = CountTable{};
+    for (std::size_t i = 1; i < nodes_.size(); ++i) {
+        children_[edge_key(nodes_[i].parent, nodes_[i].symbol)] = i;
+    }
+    CountTable transitions;
+    transitions_.for_each([&](std::uint64_t key, std::size_t count) {
+        transitions[edge_key(renumber[key >> 32], static_cast<std::uint32_t>(key & 0xFFFFFFFF))] = count;
+    });
+    transitions.set_floor(threshold);
+    transitions_ = std::move(transitions);
+}
+
+std::vector<bool> ContextTrie::used_symbols(std::size_t symbol_count) const {
+    std::vector<bool> used(symbol_count, false);
+    for (std::size_t i = 1; i < nodes_.size(); ++i) {
+        used[nodes_[i].symbol] = true;
+    }
+    transitions_.for_each([&used](std::uint64_t key, std::size_t) { used[key & 0xFFFFFFFF] = true; });
+    return used;
+}
+
+void ContextTrie::renumber_symbols(const std::vector<std::uint32_t>& renumber) {
+    children_ = CountTable{};
+    for (std::size_t i = 1; i < nodes_.size(); ++i) {
+        nodes_[i].symbol = renumber[nodes_[i].symbol];
+        children_[edge_key(nodes_[i].parent, nodes_[i].symbol)] = i;
+    }
+    CountTable transitions;
+    transitions_.for_each([&](std::uint64_t key, std::size_t count) {
+        transitions[edge_key(static_cast<std::uint32_t>(key >> 32), renumber[key & 0xFFFFFFFF])] = count;
+    });
+    transitions.set_floor(transitions_.floor());
+    transitions_ = std::move(transitions);
+}
+
+void ContextTrie::export_transitions(int order, const StringTable& symbols, StringPool& strings,
+                                     std::string_view separator,
+                                     const std::function<MarkovChain&(int)>& chain_of) const {
+    std::vector<InternedString> texts = context_texts(symbols, strings, separator);
+    std::vector<InternedString> next_texts(symbols.size());
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        next_texts[i] = strings.intern(symbols[i]);
+    }
+
+    // Number contexts by text, and symbols too. Sorting
+    // the transitions by those numbers puts them in map order with integer
+    // compares, so each one is appended at the end of its map instead of
+    // searched for.
+    std::vector<std::uint32_t> contexts(nodes_.size());
+    std::iota(contexts.begin(), contexts.end(), 0);
+    std::sort(contexts.begin(), contexts.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return texts[a] < texts[b];
+    });
+    std::vector<std::uint32_t> nexts(symbols.size());
+    std::iota(nexts.begin(), nexts.end(), 0);
+    std::sort(nexts.begin(), nexts.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return next_texts[a] < next_texts[b];
+    });
+    std::vector<std::uint32_t> context_rank(contexts.size());
+    for (std::uint32_t rank = 0; rank < contexts.size(); ++rank) {
+        context_rank[contexts[rank]] = rank;
+    }
+    std::vector<std::uint32_t> next_rank(nexts.size());
+    for (std::uint32_t rank = 0; rank < nexts.size(); ++rank) {
+        next_rank[nexts[rank]] = rank;
+    }
+
+    // One order at a time, so only that order's transitions are copied.
+    // Keys are the same shape as edge_key, in ranks.
+    std::vector<std::pair<std::uint64_t, std::size_t>> transitions;
+    int first = order == 0 ? 1 : order;
+    int last = order == 0 ? max_order_ : order;
+    for (int depth = first; depth <= last; ++depth) {
+        transitions.clear();
+        transitions_.for_each([&](std::uint64_t key, std::size_t count) {
+            auto node = static_cast<std::uint32_t>(key >> 32);
+            auto next = static_cast<std::uint32_t>(key & 0xFFFFFFFF);
+            if (nodes_[node].depth == static_cast<std::uint32_t>(depth)) {
+                transitions.emplace_back(edge_key(context_rank[node], next_rank[next]), count);
+            }
+        });
+        if (transitions.empty()) {
+            continue;
+        }
+        std::sort(transitions.begin(), transitions.end());
+
+        MarkovChain& chain = chain_of(depth);
+        for (const auto& [key, count] : transitions) {
+            std::uint32_t node = contexts[key >> 32];
+            std::uint32_t next = nexts[key & 0xFFFFFFFF];
+            // The hints are right unless the maps already held entries
+            auto context = chain.emplace_hint(chain.end(), texts[node], FrequencyMap{});
+            FrequencyMap& next_map = context->second;
+            next_map.emplace_hint(next_map.end(), next_texts[next], 0)->second += count;
+        }
+    }
+}
+
+void ContextTrie::export_chain(int order, const StringTable& symbols, MarkovChain& chain, StringPool& strings,
+                               std::string_view separator) const {
+    export_transitions(order, symbols, strings, separator, [&chain](int) -> MarkovChain& { return chain; });
+}
+
+void ContextTrie::export_chains(const StringTable& symbols, std::map<int, MarkovChain>& chains,
+                                StringPool& strings, std::string_view separator) const {
+    export_transitions(0, symbols, strings, separator,
+                       [&chains](int order) -> MarkovChain& { return chains[order]; });
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,230 @@
+#include "corpus_analyzer.hpp"
+#include "ngram_extractor.hpp"
+#include "syllable_detector.hpp"
+#include "component_extractor.hpp"
+#include "analysis_merge.hpp"
+#include "pruning.hpp"
+#include "stage_profiler.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace nameanalyzer {
+
+CorpusAnalyzer::CorpusAnalyzer(const Config& config, std::shared_ptr<StringPool> strings)
+    : letter_counts_(config.markov_order, config.approximate_epsilon),
+      syllabifier_(std::make_shared<const Syllabifier>(config.phonemes)),
+      syllable_counts_(config.markov_order, strings ? *strings : *results_.strings) {
+    // results_ is the first member, so its default pool exists by now
+    start_results(config, strings ? std::move(strings) : results_.strings);
+}
+
+void CorpusAnalyzer::start_results(const Config& config, std::shared_ptr<StringPool> strings) {
+    results_ = AnalysisResults{};
+    results_.strings = std::move(strings);
+    results_.config = config;
+
+    // Every requested order appears in the output, even if it stays empty
+    for (int order = 1; order <= config.markov_order; ++order) {
+        results_.letter_analysis.markov_chains[order];
+        if (config.enable_syllables) {
+            results_.syllable_analysis.syllable_markov[order];
+        }
+    }
+
+    word_stages_.clear();
+    if (config.profile_stages) {
+        word_stages_ = {StageTiming{"analyze.letters"}, StageTiming{"analyze.syllables"},
+                        StageTiming{"analyze.components"}};
+    }
+}
+
+void CorpusAnalyzer::reset(std::shared_ptr<StringPool> strings) {
+    Config config = results_.config;
+    start_results(config, std::move(strings));
+    letter_counts_.clear();
+    syllable_counts_ = SyllableCounts(config.markov_order, *results_.strings);
+    words_since_prune_ = 0;
+    lossy_floor_ = 0;
+}
+
+void CorpusAnalyzer::add_word(std::string_view word, std::size_t weight) {
+    analyze_word(word, weight);
+    words_added(1);
+}
+
+void CorpusAnalyzer::analyze_word(std::string_view word, std::size_t weight) {
+    const Config& config = results_.config;
+    bool profiling = !word_stages_.empty();
+    StageMark mark = profiling ? StageMark::now() : StageMark{};
+
+    results_.stats.total_words += weight;
+    results_.stats.total_characters += word.length() * weight;
+    results_.stats.length_distribution[word.length()] += weight;
+
+    decode_utf8(word, decoded_);
+    count_letters(decoded_, letter_counts_, codes_, weight);
+    if (profiling) {
+        mark.charge(word_stages_[letters_stage]);
+    }
+
+    if (!config.enable_syllables && !config.enable_components) {
+        return;
+    }
+
+    syllabifier_->split(decoded_, syllables_);
+    if (config.enable_syllables) {
+        results_.stats.total_syllables += syllables_.size() * weight;
+        accumulate_syllables(syllables_, results_.syllable_analysis, syllable_counts_, syllable_ids_,
+                             *results_.strings, weight, lossy_floor_);
+    }
+    if (profiling) {
+        mark.charge(word_stages_[syllables_stage]);
+    }
+    if (config.enable_components) {
+        accumulate_components(syllables_, results_.component_analysis, *results_.strings, weight, lossy_floor_);
+        if (profiling) {
+            mark.charge(word_stages_[components_stage]);
+        }
+    }
+}
+
+void CorpusAnalyzer::add_words(std::span<const std::string> words, std::span<const std::size_t> weights) {
+    std::size_t num_threads = static_cast<std::size_t>(std::max(results_.config.threads, 1));
+    num_threads = std::min(num_threads, words.size());
+    auto weight_of = [&weights](std::size_t i) { return weights.empty() ? 1 : weights[i]; };
+
+    if (num_threads <= 1) {
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            analyze_word(words[i], weight_of(i));
+        }
+        words_added(words.size());
+        return;
+    }
+
+    // One empty analyzer per contiguous shard of the word list. They are
+    // kept across batches, so that their approximate counters' sketches
+    // are allocated once rather than per batch. They intern into this
+    // analyzer's pool, so their keys need no moving when merged in.
+    if (shards_.size() < num_threads) {
+        shards_.resize(num_threads, CorpusAnalyzer(results_.config, results_.strings));
+    }
+    std::vector<CorpusAnalyzer>& shards = shards_;
+    auto analyze_shard = [&](std::size_t shard) {
+        std::size_t begin = words.size() * shard / num_threads;
+        std::size_t end = words.size() * (shard + 1) / num_threads;
+        for (std::size_t i = begin; i < end; ++i) {
+            shards[shard].analyze_word(words[i], weight_of(i));
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t shard = 1; shard < num_threads; ++shard) {
+        workers.emplace_back(analyze_shard, shard);
+    }
+    analyze_shard(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Pairwise tree reduction, always folding a shard into its left
+    // neighbour so the merge order (and all_syllables order) is fixed
+    for (std::size_t step = 1; step < num_threads; step *= 2) {
+        workers.clear();
+        for (std::size_t left = 0; left + step < num_threads; left += 2 * step) {
+            workers.emplace_back([&shards, left, step] {
+                shards[left].merge(std::move(shards[left + step]));
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    merge(std::move(shards[0]));
+    words_added(words.size());
+    // After words_added, which may have moved this analyzer to a new pool
+    for (std::size_t shard = 0; shard < num_threads; ++shard) {
+        shards[shard].reset(results_.strings);
+    }
+}
+
+void CorpusAnalyzer::words_added(std::size_t count) {
+    const Config& config = results_.config;
+    if (config.prune_epsilon <= 0.0) {
+        return;
+    }
+    // Lossy counting, once per batch: entries that have not kept up with
+    // epsilon times the words so far are dropped, so memory stays bounded
+    // by the entries that keep recurring rather than growing with every
+    // rare one. The maps counted directly in results_ follow the same rule
+    // as the tables, with the syllables that drop out of
+    // syllable_frequencies also leaving all_syllables.
+    words_since_prune_ += count;
+    if (words_since_prune_ < config.batch_size) {
+        return;
+    }
+    words_since_prune_ = 0;
+    auto threshold = static_cast<std::size_t>(config.prune_epsilon *
+                                              static_cast<double>(results_.stats.total_words));
+    if (threshold == 0) {
+        return;
+    }
+    prune_letter_counts(letter_counts_, threshold);
+    if (config.enable_syllables) {
+        prune_syllable_counts(syllable_counts_, threshold);
+        prune_syllable_analysis(results_.syllable_analysis, threshold + 1);
+    }
+    if (config.enable_components) {
+        prune_component_analysis(results_.component_analysis, threshold + 1);
+    }
+    // Pruned keys leave their text behind in the pool; the old pool must
+    // outlive the syllable IDs' move to the new one
+    std::shared_ptr<StringPool> old_strings = results_.strings;
+    if (compact_strings(results_)) {
+        syllable_counts_.symbols = move_strings(syllable_counts_.symbols, *results_.strings);
+    }
+    lossy_floor_ = threshold;
+    results_.stats.prune_error_bound = threshold;
+}
+
+void CorpusAnalyzer::merge(CorpusAnalyzer&& next) {
+    const Config& config = results_.config;
+
+    keep_strings(results_, next.results_);
+    merge_stats(results_.stats, next.results_.stats);
+    merge_letter_counts(letter_counts_, next.letter_counts_);
+    merge_letter_analysis(results_.letter_analysis, std::move(next.results_.letter_analysis));
+
+    if (config.enable_syllables) {
+        merge_syllable_analysis(results_.syllable_analysis, std::move(next.results_.syllable_analysis),
+                                lossy_floor_);
+        merge_syllable_counts(syllable_counts_, next.syllable_counts_);
+    }
+    if (config.enable_components) {
+        merge_component_analysis(results_.component_analysis, std::move(next.results_.component_analysis),
+                                 lossy_floor_);
+    }
+    for (std::size_t i = 0; i < word_stages_.size(); ++i) {
+        add_stage_timing(word_stages_[i], next.word_stages_[i]);
+    }
+}
+
+AnalysisResults CorpusAnalyzer::finish() {
+    export_letter_counts(letter_counts_, results_.letter_analysis, *results_.strings);
+    if (results_.config.enable_syllables) {
+        export_syllable_counts(syllable_counts_, results_.syllable_analysis, *results_.strings);
+    }
+
+    prune_results(results_);
+    update_derived_stats(results_.stats);
+
+    return std::move(results_);
+}
+
+AnalysisResults analyze_corpus(const std::vector<std::string>& words, const Config& config) {
+    CorpusAnalyzer analyzer(config);
+    analyzer.add_words(words);
+    return analyzer.finish();
+}
+
+} // namespace nameanalyzer
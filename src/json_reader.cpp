@@ -0,0 +1,526 @@
+#include "json_reader.hpp"
+#include "mapped_file.hpp"
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+JsonReader::JsonReader(std::string_view text) : text_(text) {}
+
+void JsonReader::fail(const std::string& what) const {
+    throw std::runtime_error("Invalid JSON at byte " + std::to_string(pos_) + ": " + what);
+}
+
+void JsonReader::skip_whitespace() {
+    while (pos_ < text_.size()) {
+        char c = text_[pos_];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            break;
+        }
+        ++pos_;
+    }
+}
+
+char JsonReader::peek() {
+    skip_whitespace();
+    if (pos_ >= text_.size()) {
+        fail("unexpected end of input");
+    }
+    return text_[pos_];
+}
+
+void JsonReader::expect(char c) {
+    if (peek() != c) {
+        fail(std::string("expected '") + c + "'");
+    }
+    ++pos_;
+}
+
+void JsonReader::begin_object() {
+    expect('{');
+    has_items_.push_back(false);
+}
+
+void JsonReader::begin_array() {
+    expect('[');
+    has_items_.push_back(false);
+}
+
+bool JsonReader::next_item(char close) {
+    if (peek() == close) {
+        ++pos_;
+        has_items_.pop_back();
+        return false;
+    }
+    if (has_items_.back()) {
+        expect(',');
+    }
+    has_items_.back() = true;
+    return true;
+}
+
+bool JsonReader::next_member(std::string& key) {
+    if (!next_item('}')) {
+        return false;
+    }
+    key.clear();
+    read_string_into(key);
+    expect(':');
+    return true;
+}
+
+bool JsonReader::next_element() {
+    return next_item(']');
+}
+
+static void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+void JsonReader::read_string_into(std::string& out) {
+    expect('"');
+    auto read_hex4 = [this]() {
+        if (text_.size() - pos_ < 4) {
+            fail("truncated \\u escape");
+        }
+        std::uint32_t value = 0;
+        auto result = std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, value, 16);
+        if (result.ptr != text_.data() + pos_ + 4) {
+            fail("invalid \\u escape");
+        }
+        pos_ += 4;
+        return value;
+    };
+
+    std::size_t run = pos_; // start of the pending run of unescaped bytes
+    while (true) {
+        if (pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        char c = text_[pos_];
+        if (c == '"') {
+            out.append(text_.substr(run, pos_ - run));
+            ++pos_;
+            return;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            fail("control character in string");
+        }
+        if (c != '\\') {
+            ++pos_;
+            continue;
+        }
+
+        out.append(text_.substr(run, pos_ - run));
+        if (++pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        switch (text_[pos_++]) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/'; break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                std::uint32_t cp = read_hex4();
+                if (cp >= 0xD800 && cp < 0xDC00) {
+                    // High surrogate; the low half must follow
+                    if (text_.substr(pos_, 2) != "\\u") {
+                        fail("unpaired surrogate");
+                    }
+                    pos_ += 2;
+                    std::uint32_t low = read_hex4();
+                    if (low < 0xDC00 || low >= 0xE000) {
+                        fail("unpaired surrogate");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp < 0xE000) {
+                    fail("unpaired surrogate");
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                --pos_;
+                fail("invalid escape");
+        }
+        run = pos_;
+    }
+}
+
+std::string JsonReader::read_string() {
+    std::string out;
+    read_string_into(out);
+    return out;
+}
+
+std::string_view JsonReader::number_token() {
+    skip_whitespace();
+    std::size_t start = pos_;
+    while (pos_ < text_.size()) {
+        char c = text_[pos_];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') {
+            break;
+        }
+        ++pos_;
+    }
+    if (pos_ == start) {
+        fail("expected a number");
+    }
+    return text_.substr(start, pos_ - start);
+}
+
+std::size_t JsonReader::read_size() {
+    std::string_view token = number_token();
+    std::size_t value = 0;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        fail("expected a non-negative integer");
+    }
+    return value;
+}
+
+int JsonReader::read_int() {
+    std::string_view token = number_token();
+    int value = 0;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        fail("expected an integer");
+    }
+    return value;
+}
+
+double JsonReader::read_double() {
+    // write_json_output stores non-finite numbers as null
+    if (peek() == 'n' && text_.substr(pos_, 4) == "null") {
+        pos_ += 4;
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::string_view token = number_token();
+    double value = 0.0;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        fail("expected a number");
+    }
+    return value;
+}
+
+bool JsonReader::read_bool() {
+    peek();
+    if (text_.substr(pos_, 4) == "true") {
+        pos_ += 4;
+        return true;
+    }
+    if (text_.substr(pos_, 5) == "false") {
+        pos_ += 5;
+        return false;
+    }
+    fail("expected true or false");
+}
+
+void JsonReader::skip_value() {
+    char c = peek();
+    if (c == '{') {
+        begin_object();
+        std::string key;
+        while (next_member(key)) {
+            skip_value();
+        }
+    } else if (c == '[') {
+        begin_array();
+        while (next_element()) {
+            skip_value();
+        }
+    } else if (c == '"') {
+        read_string();
+    } else if (c == 't' || c == 'f') {
+        read_bool();
+    } else if (c == 'n') {
+        if (text_.substr(pos_, 4) != "null") {
+            fail("unexpected token");
+        }
+        pos_ += 4;
+    } else {
+        number_token();
+    }
+}
+
+void JsonReader::finish() {
+    skip_whitespace();
+    if (pos_ != text_.size()) {
+        fail("unexpected data after the document");
+    }
+}
+
+// Helper to read an object of counts into a FrequencyMap
+static void read_frequency_map(JsonReader& json, FrequencyMap& freq_map, StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        // Keys are written in map order, so each one belongs at the end
+        freq_map.emplace_hint(freq_map.end(), strings.intern(key), json.read_size());
+    }
+}
+
+// Helper to read PositionalFrequencies
+static void read_positional_frequencies(JsonReader& json, PositionalFrequencies& pos_freq,
+                                        StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "start") {
+            read_frequency_map(json, pos_freq.start, strings);
+        } else if (key == "middle") {
+            read_frequency_map(json, pos_freq.middle, strings);
+        } else if (key == "end") {
+            read_frequency_map(json, pos_freq.end, strings);
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+// Helper to read Markov chains keyed "order_<n>"
+static void read_markov_chains(JsonReader& json, std::map<int, MarkovChain>& chains, StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        int order = 0;
+        bool valid = key.size() > 6 && key.compare(0, 6, "order_") == 0;
+        if (valid) {
+            auto result = std::from_chars(key.data() + 6, key.data() + key.size(), order);
+            valid = result.ec == std::errc() && result.ptr == key.data() + key.size();
+        }
+        if (!valid) {
+            throw std::runtime_error("Invalid Markov chain key in profile: " + key);
+        }
+
+        MarkovChain& chain = chains[order];
+        std::string context;
+        json.begin_object();
+        while (json.next_member(context)) {
+            auto it = chain.emplace_hint(chain.end(), strings.intern(context), FrequencyMap{});
+            read_frequency_map(json, it->second, strings);
+        }
+    }
+}
+
+// Helper to read a "phonemes" object of string arrays
+static void read_phonemes(JsonReader& json, PhonemeClasses& phonemes) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        std::vector<std::string>* entries = nullptr;
+        if (key == "vowels") {
+            entries = &phonemes.vowels;
+        } else if (key == "glides") {
+            entries = &phonemes.glides;
+        } else if (key == "onsets") {
+            entries = &phonemes.onsets;
+        } else {
+            json.skip_value();
+            continue;
+        }
+        entries->clear();
+        json.begin_array();
+        while (json.next_element()) {
+            entries->push_back(json.read_string());
+        }
+    }
+}
+
+static void read_config(JsonReader& json, Config& config) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "input_file") {
+            config.input_file = json.read_string();
+        } else if (key == "markov_order") {
+            config.markov_order = json.read_int();
+            if (config.markov_order < 1 || config.markov_order > max_markov_order) {
+                throw std::runtime_error("Invalid markov_order " + std::to_string(config.markov_order) +
+                                         ", expected 1 to " + std::to_string(max_markov_order));
+            }
+        } else if (key == "min_word_length") {
+            config.min_word_length = json.read_int();
+        } else if (key == "syllables_enabled") {
+            config.enable_syllables = json.read_bool();
+        } else if (key == "components_enabled") {
+            config.enable_components = json.read_bool();
+        } else if (key == "min_count") {
+            config.min_count = json.read_size();
+        } else if (key == "top_k_per_context") {
+            config.top_k_per_context = json.read_size();
+        } else if (key == "approximate_epsilon") {
+            config.approximate_epsilon = json.read_double();
+        } else if (key == "prune_epsilon") {
+            config.prune_epsilon = json.read_double();
+        } else if (key == "phonemes") {
+            read_phonemes(json, config.phonemes);
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+static void read_stats(JsonReader& json, CorpusStats& stats) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "total_words") {
+            stats.total_words = json.read_size();
+        } else if (key == "total_characters") {
+            stats.total_characters = json.read_size();
+        } else if (key == "total_syllables") {
+            stats.total_syllables = json.read_size();
+        } else if (key == "avg_word_length") {
+            stats.avg_word_length = json.read_double();
+        } else if (key == "avg_syllables_per_word") {
+            stats.avg_syllables_per_word = json.read_double();
+        } else if (key == "prune_error_bound") {
+            stats.prune_error_bound = json.read_size();
+        } else if (key == "length_distribution") {
+            std::string length;
+            json.begin_object();
+            while (json.next_member(length)) {
+                std::size_t len = 0;
+                auto result = std::from_chars(length.data(), length.data() + length.size(), len);
+                if (result.ec != std::errc() || result.ptr != length.data() + length.size()) {
+                    throw std::runtime_error("Invalid word length in profile: " + length);
+                }
+                stats.length_distribution[len] = json.read_size();
+            }
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+static void read_letter_analysis(JsonReader& json, LetterAnalysis& letters, StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "unigrams") {
+            read_frequency_map(json, letters.unigrams, strings);
+        } else if (key == "bigrams") {
+            read_frequency_map(json, letters.bigrams, strings);
+        } else if (key == "trigrams") {
+            read_frequency_map(json, letters.trigrams, strings);
+        } else if (key == "fourgrams") {
+            read_frequency_map(json, letters.fourgrams, strings);
+        } else if (key == "positional_bigrams") {
+            read_positional_frequencies(json, letters.positional_bigrams, strings);
+        } else if (key == "positional_trigrams") {
+            read_positional_frequencies(json, letters.positional_trigrams, strings);
+        } else if (key == "markov_chains") {
+            read_markov_chains(json, letters.markov_chains, strings);
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+static void read_syllable_analysis(JsonReader& json, SyllableAnalysis& syllables, StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "all_syllables") {
+            json.begin_array();
+            while (json.next_element()) {
+                syllables.all_syllables.intern(json.read_string(), strings);
+            }
+        } else if (key == "syllable_frequencies") {
+            read_frequency_map(json, syllables.syllable_frequencies, strings);
+        } else if (key == "positional_syllables") {
+            read_positional_frequencies(json, syllables.positional_syllables, strings);
+        } else if (key == "syllable_markov") {
+            read_markov_chains(json, syllables.syllable_markov, strings);
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+static void read_component_analysis(JsonReader& json, ComponentAnalysis& components, StringPool& strings) {
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key == "frequencies") {
+            std::string kind;
+            json.begin_object();
+            while (json.next_member(kind)) {
+                if (kind == "onsets") {
+                    read_frequency_map(json, components.frequencies.onsets, strings);
+                } else if (kind == "nuclei") {
+                    read_frequency_map(json, components.frequencies.nuclei, strings);
+                } else if (kind == "codas") {
+                    read_frequency_map(json, components.frequencies.codas, strings);
+                } else {
+                    json.skip_value();
+                }
+            }
+        } else if (key == "positional_onsets") {
+            read_positional_frequencies(json, components.positional_onsets, strings);
+        } else if (key == "positional_codas") {
+            read_positional_frequencies(json, components.positional_codas, strings);
+        } else {
+            json.skip_value();
+        }
+    }
+}
+
+AnalysisResults read_json_profile(const std::string& filename) {
+    MappedFile file(filename);
+    JsonReader json(file.contents());
+    AnalysisResults results;
+
+    try {
+        std::string key;
+        json.begin_object();
+        while (json.next_member(key)) {
+            if (key == "config") {
+                read_config(json, results.config);
+            } else if (key == "stats") {
+                read_stats(json, results.stats);
+            } else if (key == "letter_analysis") {
+                read_letter_analysis(json, results.letter_analysis, *results.strings);
+            } else if (key == "syllable_analysis") {
+                read_syllable_analysis(json, results.syllable_analysis, *results.strings);
+            } else if (key == "component_analysis") {
+                read_component_analysis(json, results.component_analysis, *results.strings);
+            } else if (key == "sampling") {
+                // Derived from the counts; rewritten when the profile is
+                results.config.sampling_tables = true;
+                json.skip_value();
+            } else {
+                json.skip_value();
+            }
+        }
+        json.finish();
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("Failed to read profile " + filename + ": " + e.what());
+    }
+
+    return results;
+}
+
+} // namespace nameanalyzer
@@ -1,129 +1,457 @@
 #include "json_writer.hpp"
-#include <jsom/json_document.hpp>
-#include <fstream>
-
-using namespace jsom;
+#include "alias_table.hpp"
+#include <charconv>
+#include <cmath>
 
 namespace nameanalyzer {
 
-// Helper to convert FrequencyMap to JsonDocument
-static JsonDocument frequency_map_to_json(const FrequencyMap& freq_map) {
-    std::map<std::string, JsonDocument> obj;
+JsonWriter::JsonWriter(OutputFile& out, bool pretty) : out_(out), pretty_(pretty) {}
+
+void JsonWriter::newline() {
+    out_.put('\n');
+    for (std::size_t i = 0; i < scopes_.size(); ++i) {
+        out_.write("  ");
+    }
+}
+
+void JsonWriter::before_value() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!scopes_.empty() && scopes_.back().is_array) {
+        if (scopes_.back().has_items) {
+            out_.write(pretty_ ? ", " : ",");
+        }
+        scopes_.back().has_items = true;
+    }
+}
+
+void JsonWriter::begin_object() {
+    before_value();
+    out_.put('{');
+    scopes_.push_back({false, false});
+}
+
+void JsonWriter::end_object() {
+    bool has_items = scopes_.back().has_items;
+    scopes_.pop_back();
+    if (pretty_ && has_items) {
+        newline();
+    }
+    out_.put('}');
+}
+
+void JsonWriter::begin_array() {
+    before_value();
+    out_.put('[');
+    scopes_.push_back({true, false});
+}
+
+void JsonWriter::end_array() {
+    scopes_.pop_back();
+    out_.put(']');
+}
+
+void JsonWriter::key(std::string_view name) {
+    Scope& scope = scopes_.back();
+    if (scope.has_items) {
+        out_.put(',');
+    }
+    scope.has_items = true;
+    if (pretty_) {
+        newline();
+    }
+    write_string(name);
+    out_.write(pretty_ ? ": " : ":");
+    after_key_ = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+    before_value();
+    write_string(text);
+}
+
+void JsonWriter::value(std::size_t number) {
+    before_value();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.write({buffer, static_cast<std::size_t>(result.ptr - buffer)});
+}
+
+void JsonWriter::value(int number) {
+    before_value();
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.write({buffer, static_cast<std::size_t>(result.ptr - buffer)});
+}
+
+void JsonWriter::value(double number) {
+    before_value();
+    if (!std::isfinite(number)) {
+        // JSON has no representation for NaN or infinity
+        out_.write("null");
+        return;
+    }
+    // Six significant digits, as a default-formatted std::ostream prints
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number,
+                                std::chars_format::general, 6);
+    out_.write({buffer, static_cast<std::size_t>(result.ptr - buffer)});
+}
+
+void JsonWriter::exact_value(double number) {
+    before_value();
+    if (!std::isfinite(number)) {
+        out_.write("null");
+        return;
+    }
+    // Shortest round-trip representation
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.write({buffer, static_cast<std::size_t>(result.ptr - buffer)});
+}
+
+void JsonWriter::value(bool flag) {
+    before_value();
+    out_.write(flag ? "true" : "false");
+}
+
+void JsonWriter::null() {
+    before_value();
+    out_.write("null");
+}
+
+void JsonWriter::write_string(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+
+    out_.put('"');
+    std::size_t run = 0; // start of the pending run of bytes that need no escaping
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out_.write(text.substr(run, i - run));
+        run = i + 1;
+        switch (c) {
+            case '"':  out_.write("\\\""); break;
+            case '\\': out_.write("\\\\"); break;
+            case '\b': out_.write("\\b"); break;
+            case '\f': out_.write("\\f"); break;
+            case '\n': out_.write("\\n"); break;
+            case '\r': out_.write("\\r"); break;
+            case '\t': out_.write("\\t"); break;
+            default: {
+                char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out_.write({escape, sizeof(escape)});
+            }
+        }
+    }
+    out_.write(text.substr(run));
+    out_.put('"');
+}
+
+// Helper to write a FrequencyMap as an object of counts
+static void write_frequency_map(JsonWriter& json, const FrequencyMap& freq_map) {
+    json.begin_object();
     for (const auto& [key, count] : freq_map) {
-        obj[key] = JsonDocument(static_cast<int>(count));
+        json.key(key);
+        json.value(count);
+    }
+    json.end_object();
+}
+
+// Helper to write PositionalFrequencies
+static void write_positional_frequencies(JsonWriter& json, const PositionalFrequencies& pos_freq) {
+    json.begin_object();
+    json.key("start");
+    write_frequency_map(json, pos_freq.start);
+    json.key("middle");
+    write_frequency_map(json, pos_freq.middle);
+    json.key("end");
+    write_frequency_map(json, pos_freq.end);
+    json.end_object();
+}
+
+// Helper to write Markov chains keyed "order_<n>"
+static void write_markov_chains(JsonWriter& json, const std::map<int, MarkovChain>& chains) {
+    json.begin_object();
+    for (const auto& [order, chain] : chains) {
+        json.key("order_" + std::to_string(order));
+        json.begin_object();
+        for (const auto& [context, next_map] : chain) {
+            json.key(context);
+            write_frequency_map(json, next_map);
+        }
+        json.end_object();
+    }
+    json.end_object();
+}
+
+// Helper to write a FrequencyMap as a sampling table: its symbols in key
+// order with their probabilities and Walker alias columns
+static void write_sampling_table(JsonWriter& json, const FrequencyMap& freq_map) {
+    std::vector<std::size_t> counts;
+    counts.reserve(freq_map.size());
+    for (const auto& [symbol, count] : freq_map) {
+        counts.push_back(count);
     }
-    return JsonDocument(obj);
+    AliasTable table(counts);
+
+    json.begin_object();
+    json.key("symbols");
+    json.begin_array();
+    for (const auto& [symbol, count] : freq_map) {
+        json.value(symbol);
+    }
+    json.end_array();
+    json.key("probabilities");
+    json.begin_array();
+    for (double probability : table.probabilities()) {
+        json.exact_value(probability);
+    }
+    json.end_array();
+    json.key("alias_thresholds");
+    json.begin_array();
+    for (double threshold : table.thresholds()) {
+        json.exact_value(threshold);
+    }
+    json.end_array();
+    json.key("aliases");
+    json.begin_array();
+    for (std::uint32_t alias : table.aliases()) {
+        json.value(static_cast<std::size_t>(alias));
+    }
+    json.end_array();
+    json.end_object();
 }
 
-// Helper to convert PositionalFrequencies to JsonDocument
-static JsonDocument positional_frequencies_to_json(const PositionalFrequencies& pos_freq) {
-    return JsonDocument{
-        {"start", frequency_map_to_json(pos_freq.start)},
-        {"middle", frequency_map_to_json(pos_freq.middle)},
-        {"end", frequency_map_to_json(pos_freq.end)}
-    };
+// Helper to write one sampling table per context of each Markov order
+static void write_markov_sampling(JsonWriter& json, const std::map<int, MarkovChain>& chains) {
+    json.begin_object();
+    for (const auto& [order, chain] : chains) {
+        json.key("order_" + std::to_string(order));
+        json.begin_object();
+        for (const auto& [context, next_map] : chain) {
+            json.key(context);
+            write_sampling_table(json, next_map);
+        }
+        json.end_object();
+    }
+    json.end_object();
 }
 
-// Helper to convert MarkovChain to JsonDocument
-static JsonDocument markov_chain_to_json(const MarkovChain& chain) {
-    std::map<std::string, JsonDocument> obj;
-    for (const auto& [context, next_map] : chain) {
-        obj[context] = frequency_map_to_json(next_map);
+// Helper to write a sampling table, or null for an empty distribution
+static void write_sampling_table_or_null(JsonWriter& json, const FrequencyMap& freq_map) {
+    if (freq_map.empty()) {
+        json.null();
+    } else {
+        write_sampling_table(json, freq_map);
+    }
+}
+
+void write_stage_timing(JsonWriter& json, const StageTiming& stage) {
+    json.begin_object();
+    json.key("wall_seconds");
+    json.value(stage.wall_seconds);
+    if (stage.cpu_seconds) {
+        json.key("cpu_seconds");
+        json.value(*stage.cpu_seconds);
+    }
+    json.key("operator_new_calls");
+    json.value(stage.allocations);
+    json.key("operator_new_bytes");
+    json.value(stage.allocated_bytes);
+    if (stage.peak_rss_kb) {
+        json.key("peak_rss_kb");
+        json.value(static_cast<std::size_t>(*stage.peak_rss_kb));
     }
-    return JsonDocument(obj);
+    json.end_object();
 }
 
-void write_json_output(const AnalysisResults& results, const std::string& filename) {
+void write_stage_timings(JsonWriter& json, const std::vector<StageTiming>& stages) {
+    json.begin_object();
+    for (const StageTiming& stage : stages) {
+        json.key(stage.stage);
+        write_stage_timing(json, stage);
+    }
+    json.end_object();
+}
+
+void write_json_output(const AnalysisResults& results, const std::string& filename, bool pretty) {
+    OutputFile out(filename);
+    JsonWriter json(out, pretty);
+
+    json.begin_object();
+
     // Config section
-    JsonDocument config{
-        {"input_file", JsonDocument(results.config.input_file)},
-        {"markov_order", JsonDocument(results.config.markov_order)},
-        {"min_word_length", JsonDocument(results.config.min_word_length)},
-        {"syllables_enabled", JsonDocument(results.config.enable_syllables)},
-        {"components_enabled", JsonDocument(results.config.enable_components)}
-    };
+    json.key("config");
+    json.begin_object();
+    json.key("input_file");
+    json.value(results.config.input_file);
+    json.key("markov_order");
+    json.value(results.config.markov_order);
+    json.key("min_word_length");
+    json.value(results.config.min_word_length);
+    json.key("syllables_enabled");
+    json.value(results.config.enable_syllables);
+    json.key("components_enabled");
+    json.value(results.config.enable_components);
+    // Pruning and approximation settings appear only when asked for
+    if (results.config.min_count > 1) {
+        json.key("min_count");
+        json.value(results.config.min_count);
+    }
+    if (results.config.top_k_per_context > 0) {
+        json.key("top_k_per_context");
+        json.value(results.config.top_k_per_context);
+    }
+    if (results.config.approximate_epsilon > 0.0) {
+        json.key("approximate_epsilon");
+        json.value(results.config.approximate_epsilon);
+    }
+    if (results.config.prune_epsilon > 0.0) {
+        json.key("prune_epsilon");
+        json.value(results.config.prune_epsilon);
+    }
+    // Syllabification rules, unless they are the built-in ones
+    if (results.config.phonemes != PhonemeClasses{}) {
+        const PhonemeClasses& phonemes = results.config.phonemes;
+        json.key("phonemes");
+        json.begin_object();
+        for (const auto& [name, entries] : {std::pair{"vowels", &phonemes.vowels},
+                                            std::pair{"glides", &phonemes.glides},
+                                            std::pair{"onsets", &phonemes.onsets}}) {
+            json.key(name);
+            json.begin_array();
+            for (const auto& entry : *entries) {
+                json.value(entry);
+            }
+            json.end_array();
+        }
+        json.end_object();
+    }
+    json.end_object();
 
     // Stats section
-    std::map<std::string, JsonDocument> length_dist;
+    json.key("stats");
+    json.begin_object();
+    json.key("total_words");
+    json.value(results.stats.total_words);
+    json.key("total_characters");
+    json.value(results.stats.total_characters);
+    json.key("total_syllables");
+    json.value(results.stats.total_syllables);
+    json.key("avg_word_length");
+    json.value(results.stats.avg_word_length);
+    json.key("avg_syllables_per_word");
+    json.value(results.stats.avg_syllables_per_word);
+    json.key("length_distribution");
+    json.begin_object();
     for (const auto& [len, count] : results.stats.length_distribution) {
-        length_dist[std::to_string(len)] = JsonDocument(static_cast<int>(count));
+        json.key(std::to_string(len));
+        json.value(count);
     }
-
-    JsonDocument stats{
-        {"total_words", JsonDocument(static_cast<int>(results.stats.total_words))},
-        {"total_characters", JsonDocument(static_cast<int>(results.stats.total_characters))},
-        {"total_syllables", JsonDocument(static_cast<int>(results.stats.total_syllables))},
-        {"avg_word_length", JsonDocument(results.stats.avg_word_length)},
-        {"avg_syllables_per_word", JsonDocument(results.stats.avg_syllables_per_word)},
-        {"length_distribution", JsonDocument(length_dist)}
-    };
+    json.end_object();
+    if (results.stats.prune_error_bound > 0) {
+        json.key("prune_error_bound");
+        json.value(results.stats.prune_error_bound);
+    }
+    if (!results.stats.timings.empty()) {
+        json.key("timings");
+        write_stage_timings(json, results.stats.timings);
+    }
+    json.end_object();
 
     // Letter analysis section
-    std::map<std::string, JsonDocument> markov_chains;
-    for (const auto& [order, chain] : results.letter_analysis.markov_chains) {
-        markov_chains["order_" + std::to_string(order)] = markov_chain_to_json(chain);
-    }
-
-    JsonDocument letter_analysis{
-        {"unigrams", frequency_map_to_json(results.letter_analysis.unigrams)},
-        {"bigrams", frequency_map_to_json(results.letter_analysis.bigrams)},
-        {"trigrams", frequency_map_to_json(results.letter_analysis.trigrams)},
-        {"fourgrams", frequency_map_to_json(results.letter_analysis.fourgrams)},
-        {"positional_bigrams", positional_frequencies_to_json(results.letter_analysis.positional_bigrams)},
-        {"positional_trigrams", positional_frequencies_to_json(results.letter_analysis.positional_trigrams)},
-        {"markov_chains", JsonDocument(markov_chains)}
-    };
-
-    // Build root document
-    std::map<std::string, JsonDocument> root_map;
-    root_map["config"] = config;
-    root_map["stats"] = stats;
-    root_map["letter_analysis"] = letter_analysis;
+    const LetterAnalysis& letters = results.letter_analysis;
+    json.key("letter_analysis");
+    json.begin_object();
+    json.key("unigrams");
+    write_frequency_map(json, letters.unigrams);
+    json.key("bigrams");
+    write_frequency_map(json, letters.bigrams);
+    json.key("trigrams");
+    write_frequency_map(json, letters.trigrams);
+    json.key("fourgrams");
+    write_frequency_map(json, letters.fourgrams);
+    json.key("positional_bigrams");
+    write_positional_frequencies(json, letters.positional_bigrams);
+    json.key("positional_trigrams");
+    write_positional_frequencies(json, letters.positional_trigrams);
+    json.key("markov_chains");
+    write_markov_chains(json, letters.markov_chains);
+    json.end_object();
 
     // Syllable analysis (if enabled)
     if (results.config.enable_syllables) {
-        std::vector<JsonDocument> syllables_array;
-        for (const auto& syll : results.syllable_analysis.all_syllables) {
-            syllables_array.push_back(JsonDocument(syll));
-        }
-
-        std::map<std::string, JsonDocument> syllable_markov;
-        for (const auto& [order, chain] : results.syllable_analysis.syllable_markov) {
-            syllable_markov["order_" + std::to_string(order)] = markov_chain_to_json(chain);
+        const SyllableAnalysis& syllables = results.syllable_analysis;
+        json.key("syllable_analysis");
+        json.begin_object();
+        json.key("all_syllables");
+        json.begin_array();
+        for (const auto& syll : syllables.all_syllables) {
+            json.value(syll);
         }
-
-        root_map["syllable_analysis"] = JsonDocument{
-            {"all_syllables", JsonDocument(syllables_array)},
-            {"syllable_frequencies", frequency_map_to_json(results.syllable_analysis.syllable_frequencies)},
-            {"positional_syllables", positional_frequencies_to_json(results.syllable_analysis.positional_syllables)},
-            {"syllable_markov", JsonDocument(syllable_markov)}
-        };
+        json.end_array();
+        json.key("syllable_frequencies");
+        write_frequency_map(json, syllables.syllable_frequencies);
+        json.key("positional_syllables");
+        write_positional_frequencies(json, syllables.positional_syllables);
+        json.key("syllable_markov");
+        write_markov_chains(json, syllables.syllable_markov);
+        json.end_object();
     }
 
     // Component analysis (if enabled)
     if (results.config.enable_components) {
-        JsonDocument frequencies{
-            {"onsets", frequency_map_to_json(results.component_analysis.frequencies.onsets)},
-            {"nuclei", frequency_map_to_json(results.component_analysis.frequencies.nuclei)},
-            {"codas", frequency_map_to_json(results.component_analysis.frequencies.codas)}
-        };
-
-        root_map["component_analysis"] = JsonDocument{
-            {"frequencies", frequencies},
-            {"positional_onsets", positional_frequencies_to_json(results.component_analysis.positional_onsets)},
-            {"positional_codas", positional_frequencies_to_json(results.component_analysis.positional_codas)}
-        };
+        const ComponentAnalysis& components = results.component_analysis;
+        json.key("component_analysis");
+        json.begin_object();
+        json.key("frequencies");
+        json.begin_object();
+        json.key("onsets");
+        write_frequency_map(json, components.frequencies.onsets);
+        json.key("nuclei");
+        write_frequency_map(json, components.frequencies.nuclei);
+        json.key("codas");
+        write_frequency_map(json, components.frequencies.codas);
+        json.end_object();
+        json.key("positional_onsets");
+        write_positional_frequencies(json, components.positional_onsets);
+        json.key("positional_codas");
+        write_positional_frequencies(json, components.positional_codas);
+        json.end_object();
     }
 
-    // Create document and write to file
-    JsonDocument doc(root_map);
-
-    std::ofstream outfile(filename);
-    if (!outfile) {
-        throw std::runtime_error("Failed to open output file: " + filename);
+    // Sampling tables (optional)
+    if (results.config.sampling_tables) {
+        json.key("sampling");
+        json.begin_object();
+        json.key("letter_markov");
+        write_markov_sampling(json, letters.markov_chains);
+        if (results.config.enable_syllables) {
+            json.key("syllable_markov");
+            write_markov_sampling(json, results.syllable_analysis.syllable_markov);
+        }
+        if (results.config.enable_components) {
+            const ComponentFrequencies& frequencies = results.component_analysis.frequencies;
+            json.key("components");
+            json.begin_object();
+            json.key("onsets");
+            write_sampling_table_or_null(json, frequencies.onsets);
+            json.key("nuclei");
+            write_sampling_table_or_null(json, frequencies.nuclei);
+            json.key("codas");
+            write_sampling_table_or_null(json, frequencies.codas);
+            json.end_object();
+        }
+        json.end_object();
     }
 
-    outfile << doc.to_json(true); // true = pretty print
+    json.end_object();
+    out.close();
 }
 
 } // namespace nameanalyzer
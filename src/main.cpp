@@ -1,109 +1,401 @@
 #include "cli_parser.hpp"
 #include "word_reader.hpp"
-#include "ngram_extractor.hpp"
-#include "syllable_detector.hpp"
-#include "component_extractor.hpp"
+#include "analyzer.hpp"
 #include "json_writer.hpp"
+#include "json_reader.hpp"
+#include "analysis_merge.hpp"
+#include "pruning.hpp"
+#include "stage_profiler.hpp"
+#include "profile_writer.hpp"
+#include "syllabifier.hpp"
+#include "profile_index.hpp"
+#include "profile_server.hpp"
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace nameanalyzer;
 
+// The options a profile was built with that dropped or approximated
+// counts, as "--min-count 5, --approximate 0.001"; empty if it is exact
+static std::string inexact_options(const Config& config) {
+    std::ostringstream options;
+    auto add = [&options](std::string_view option, auto value) {
+        options << (options.tellp() > 0 ? ", " : "") << option << " " << value;
+    };
+    if (config.min_count > 1) {
+        add("--min-count", config.min_count);
+    }
+    if (config.top_k_per_context > 0) {
+        add("--top-k-per-context", config.top_k_per_context);
+    }
+    if (config.approximate_epsilon > 0.0) {
+        add("--approximate", config.approximate_epsilon);
+    }
+    if (config.prune_epsilon > 0.0) {
+        add("--prune-epsilon", config.prune_epsilon);
+    }
+    return options.str();
+}
+
+// "merge" subcommand: sum the counts of several profiles into one
+static int run_merge(int argc, char* argv[]) {
+    auto config_opt = parse_merge_arguments(argc, argv);
+    if (!config_opt) {
+        return 1;
+    }
+    const MergeConfig& config = *config_opt;
+
+    // Profiles are read one at a time, so memory holds the merged counts
+    // plus a single input
+    AnalysisResults merged;
+    std::string input_files;
+    // The merged profile records the strongest pruning that any input or
+    // the options applied, and the largest approximation error
+    Config pruning;
+    pruning.min_count = config.min_count;
+    pruning.top_k_per_context = config.top_k_per_context;
+    for (std::size_t i = 0; i < config.input_files.size(); ++i) {
+        const std::string& filename = config.input_files[i];
+        if (config.verbose) {
+            std::cout << "Reading " << filename << "...\n";
+        }
+        AnalysisResults profile = read_json_profile(filename);
+
+        // Counts a part dropped cannot be added back, so the sum would
+        // silently differ from a single run over the whole corpus
+        std::string inexact = inexact_options(profile.config);
+        if (!inexact.empty()) {
+            if (!config.force) {
+                throw std::runtime_error("Profile " + filename + " was built with " + inexact +
+                                         ", so merging it cannot match a single run; pass --force to merge it anyway");
+            }
+            std::cerr << "Warning: profile " << filename << " was built with " << inexact
+                      << "; the merged counts can differ from a single run over all inputs\n";
+        }
+
+        input_files += (i == 0 ? "" : ",") + profile.config.input_file;
+        keep_strongest_pruning(pruning, profile.config);
+        if (i == 0) {
+            merged = std::move(profile);
+            continue;
+        }
+
+        const Config& first = merged.config;
+        const Config& other = profile.config;
+        if (other.markov_order != first.markov_order ||
+            other.min_word_length != first.min_word_length ||
+            other.enable_syllables != first.enable_syllables ||
+            other.enable_components != first.enable_components ||
+            other.phonemes != first.phonemes) {
+            throw std::runtime_error("Profile " + filename + " was built with different settings than " +
+                                     config.input_files.front());
+        }
+        merge_results(merged, std::move(profile));
+    }
+    merged.config.input_file = input_files;
+    merged.config.min_count = pruning.min_count;
+    merged.config.top_k_per_context = pruning.top_k_per_context;
+    merged.config.approximate_epsilon = pruning.approximate_epsilon;
+    merged.config.prune_epsilon = pruning.prune_epsilon;
+    merged.config.sampling_tables = merged.config.sampling_tables || config.sampling_tables;
+    prune_results(merged);
+
+    if (config.verbose) {
+        std::cout << "Merged " << config.input_files.size() << " profiles covering "
+                  << merged.stats.total_words << " words\n"
+                  << "Writing results to " << config.output_file << "...\n";
+    }
+    write_json_output(merged, config.output_file, !config.compact_output);
+    if (!config.binary_output_file.empty()) {
+        write_binary_profile(merged, config.binary_output_file);
+    }
+
+    if (!config.verbose) {
+        std::cout << "Merge complete. Output written to " << config.output_file << "\n";
+    }
+    return 0;
+}
+
+// "serve" subcommand: answer queries about one profile over a socket
+static int run_serve(int argc, char* argv[]) {
+    auto config_opt = parse_serve_arguments(argc, argv);
+    if (!config_opt) {
+        return 1;
+    }
+    const ServeConfig& config = *config_opt;
+
+    AnalysisResults results;
+    if (!config.profile_file.empty()) {
+        if (config.verbose) {
+            std::cout << "Loading " << config.profile_file << "...\n";
+        }
+        results = read_json_profile(config.profile_file);
+    } else {
+        if (config.verbose) {
+            std::cout << "Analyzing " << config.words_file << "...\n";
+        }
+        Config analysis;
+        analysis.input_file = config.words_file;
+        analysis.threads = config.threads;
+        WordReader reader(analysis.input_file, analysis.min_word_length, false, analysis.threads);
+        Analyzer analyzer(analysis);
+        std::vector<std::string> batch;
+        while (reader.next_batch(batch, analysis.batch_size)) {
+            analyzer.add_prepared(batch);
+        }
+        results = analyzer.finish();
+    }
+    if (config.verbose) {
+        std::cout << "Indexing " << results.stats.total_words << " words...\n";
+    }
+    ProfileIndex index(std::move(results));
+    serve_profile(index, config.socket_path, config.verbose);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     try {
+        if (argc >= 2 && std::string_view(argv[1]) == "merge") {
+            return run_merge(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "serve") {
+            return run_serve(argc, argv);
+        }
+
         // Parse command-line arguments
         auto config_opt = parse_arguments(argc, argv);
         if (!config_opt) {
             return 1; // Help was shown or parsing failed
         }
         Config config = *config_opt;
+        if (!config.phonemes_file.empty()) {
+            config.phonemes = read_phoneme_file(config.phonemes_file);
+        }
+
+        // Optional per-stage measurements; stages that are entered more than
+        // once (reading and analysis alternate per batch) accumulate
+        std::optional<StageProfiler> profiler;
+        if (config.profile_stages) {
+            enable_allocation_counting();
+            profiler.emplace();
+        }
+        auto begin_stage = [&profiler](std::string_view stage) {
+            if (profiler) {
+                profiler->begin(stage);
+            }
+        };
+        auto end_stage = [&profiler] {
+            if (profiler) {
+                profiler->end();
+            }
+        };
+
+        // When updating, the new words are analyzed with the settings the
+        // existing profile was built with (see continued_config), and only
+        // they are read
+        AnalysisResults previous;
+        std::size_t previous_words = 0;
+        bool updating = !config.update_profile.empty();
+        if (updating) {
+            begin_stage("load_profile");
+            previous = read_json_profile(config.update_profile);
+            end_stage();
+            previous_words = previous.stats.total_words;
+            if (previous.config.min_word_length != config.min_word_length) {
+                throw std::runtime_error(
+                    "Profile " + config.update_profile + " was built with a minimum word length of " +
+                    std::to_string(previous.config.min_word_length) + "; pass --min-length " +
+                    std::to_string(previous.config.min_word_length) + " to update it");
+            }
+            if (!config.phonemes_file.empty() && config.phonemes != previous.config.phonemes) {
+                throw std::runtime_error("Profile " + config.update_profile +
+                                         " was built with different syllabification rules than " +
+                                         config.phonemes_file);
+            }
+        }
+        // Once continued, config.input_file lists the profile's inputs too
+        const std::string input_file = config.input_file;
+        Analyzer analyzer = updating ? Analyzer(std::move(previous), config) : Analyzer(config);
+        config = analyzer.config();
 
         if (config.verbose) {
             std::cout << "NameAnalyzer - Word Pattern Analysis\n";
             std::cout << "=====================================\n";
-            std::cout << "Input file: " << config.input_file << "\n";
+            std::cout << "Input file: " << input_file << "\n";
             std::cout << "Output file: " << config.output_file << "\n";
+            if (updating) {
+                std::cout << "Updating profile: " << config.update_profile << " ("
+                          << previous_words << " words)\n";
+            }
+            if (!config.binary_output_file.empty()) {
+                std::cout << "Binary profile: " << config.binary_output_file << "\n";
+            }
             std::cout << "Markov order: " << config.markov_order << "\n";
             std::cout << "Syllable analysis: " << (config.enable_syllables ? "enabled" : "disabled") << "\n";
+            if (!config.phonemes_file.empty()) {
+                std::cout << "Phoneme classes: " << config.phonemes_file << "\n";
+            }
             std::cout << "Component analysis: " << (config.enable_components ? "enabled" : "disabled") << "\n";
+            std::cout << "Threads: " << config.threads << "\n";
+            if (config.weighted_input) {
+                std::cout << "Input: weighted frequency list\n";
+            }
+            if (config.dedupe) {
+                std::cout << "Repeated words: collapsed before analysis\n";
+            }
+            if (config.min_count > 1) {
+                std::cout << "Minimum count: " << config.min_count << "\n";
+            }
+            if (config.top_k_per_context > 0) {
+                std::cout << "Top transitions per context: " << config.top_k_per_context << "\n";
+            }
+            if (config.approximate_epsilon > 0.0) {
+                std::cout << "Approximate counting: epsilon " << config.approximate_epsilon << "\n";
+            }
+            if (config.prune_epsilon > 0.0) {
+                std::cout << "Lossy counting: epsilon " << config.prune_epsilon << "\n";
+            }
             std::cout << "\n";
         }
 
-        // Read words from input file
+        // Stream words from the input file in batches; each batch is
+        // analyzed in a single pass (letters, Markov chains, syllables and
+        // components together) and then dropped, so memory use is bounded
+        // by the statistics rather than the corpus
         if (config.verbose) {
-            std::cout << "Reading words from file...\n";
+            std::cout << "Reading and analyzing words in batches of " << config.batch_size << "...\n";
+        }
+        WordReader reader(input_file, config.min_word_length, config.weighted_input, config.threads);
+        std::vector<std::string> batch;
+        std::vector<std::size_t> weights;  // Empty when every word counts once
+        if (config.dedupe) {
+            // Tally the whole input first, so that each distinct word is
+            // analyzed once; memory then grows with the vocabulary
+            begin_stage("read");
+            WordTally tally;
+            std::string_view word;
+            std::size_t weight;
+            while (reader.next_word(word, weight)) {
+                tally.add(word, weight);
+            }
+            tally.take(batch, weights);
+            end_stage();
+            begin_stage("analyze");
+            std::span<const std::string> words = batch;
+            for (std::size_t first = 0; first < words.size(); first += config.batch_size) {
+                std::size_t count = std::min(config.batch_size, words.size() - first);
+                analyzer.add_prepared(words.subspan(first, count),
+                                      std::span<const std::size_t>(weights).subspan(first, count));
+            }
+            end_stage();
+        } else {
+            while (true) {
+                begin_stage("read");
+                bool more = config.weighted_input ? reader.next_batch(batch, weights, config.batch_size)
+                                                  : reader.next_batch(batch, config.batch_size);
+                end_stage();
+                if (!more) {
+                    break;
+                }
+                begin_stage("analyze");
+                analyzer.add_prepared(batch, weights);
+                end_stage();
+            }
+        }
+        if (profiler) {
+            for (const StageTiming& stage : analyzer.stage_timings()) {
+                profiler->add(stage);
+            }
+        }
+        if (reader.words_read() == 0 && !updating) {
+            throw std::runtime_error("No valid words found in file");
         }
-        auto words = read_words(config.input_file, config.min_word_length);
         if (config.verbose) {
-            std::cout << "Loaded " << words.size() << " words\n\n";
+            std::cout << "Analyzed " << reader.occurrences_read() << " words";
+            if (config.weighted_input || config.dedupe) {
+                std::cout << " as " << analyzer.words_added() << " weighted entries";
+            }
+            std::cout << "\n";
         }
+        // Finishing an update also merges the new counts into the profile
+        begin_stage("finish");
+        AnalysisResults results = analyzer.finish();
+        end_stage();
 
-        // Initialize results structure
-        AnalysisResults results;
-        results.config = config;
+        if (updating && config.verbose) {
+            std::cout << "Profile now covers " << results.stats.total_words << " words\n";
+        }
 
-        // Calculate basic statistics
-        if (config.verbose) {
-            std::cout << "Calculating statistics...\n";
+        if (config.verbose && config.enable_syllables) {
+            std::cout << "Found " << results.syllable_analysis.all_syllables.size()
+                      << " unique syllables\n";
         }
-        results.stats.total_words = words.size();
-        for (const auto& word : words) {
-            results.stats.total_characters += word.length();
-            results.stats.length_distribution[word.length()]++;
+
+        if (config.verbose && config.enable_components) {
+            std::cout << "Found " << results.component_analysis.frequencies.onsets.size()
+                      << " unique onsets, "
+                      << results.component_analysis.frequencies.nuclei.size()
+                      << " unique nuclei, "
+                      << results.component_analysis.frequencies.codas.size()
+                      << " unique codas\n";
         }
-        results.stats.avg_word_length = static_cast<double>(results.stats.total_characters) /
-                                        static_cast<double>(results.stats.total_words);
 
-        // Letter-level analysis
+        // Write JSON output
         if (config.verbose) {
-            std::cout << "Analyzing letter patterns and building Markov chains...\n";
+            std::cout << "\nWriting results to " << config.output_file << "...\n";
         }
-        results.letter_analysis = analyze_letters(words, config.markov_order);
-
-        // Syllable analysis (if enabled)
-        if (config.enable_syllables) {
-            if (config.verbose) {
-                std::cout << "Detecting syllables...\n";
-            }
-            results.syllable_analysis = analyze_syllables(words, config.markov_order);
-
-            // Count total syllables
-            for (const auto& [syll, count] : results.syllable_analysis.syllable_frequencies) {
-                results.stats.total_syllables += count;
-            }
-            results.stats.avg_syllables_per_word =
-                static_cast<double>(results.stats.total_syllables) /
-                static_cast<double>(results.stats.total_words);
+        if (config.embed_timings) {
+            // Covers the stages so far; writing the output cannot time itself
+            results.stats.timings = profiler->stages();
+        }
+        begin_stage("write_json");
+        write_json_output(results, config.output_file, !config.compact_output);
+        end_stage();
 
+        if (!config.binary_output_file.empty()) {
             if (config.verbose) {
-                std::cout << "Found " << results.syllable_analysis.all_syllables.size()
-                          << " unique syllables\n";
+                std::cout << "Writing binary profile to " << config.binary_output_file << "...\n";
             }
+            begin_stage("write_binary");
+            write_binary_profile(results, config.binary_output_file);
+            end_stage();
         }
 
-        // Component analysis (if enabled)
-        if (config.enable_components) {
+        if (profiler) {
             if (config.verbose) {
-                std::cout << "Extracting onset/nucleus/coda components...\n";
+                std::cout << "\nStage                  wall s     cpu s  operator new   peak RSS KiB\n";
+                for (const StageTiming& stage : profiler->stages()) {
+                    std::cout << std::left << std::setw(20) << stage.stage << std::right << std::fixed
+                              << std::setprecision(3) << std::setw(10) << stage.wall_seconds
+                              << std::setw(10);
+                    if (stage.cpu_seconds) {
+                        std::cout << *stage.cpu_seconds;
+                    } else {
+                        std::cout << "-";
+                    }
+                    std::cout << std::setw(14) << stage.allocations << std::setw(15);
+                    if (stage.peak_rss_kb) {
+                        std::cout << *stage.peak_rss_kb;
+                    } else {
+                        std::cout << "-";
+                    }
+                    std::cout << "\n";
+                }
+                std::cout << "\n";
             }
-            results.component_analysis = analyze_components(words);
-
-            if (config.verbose) {
-                std::cout << "Found " << results.component_analysis.frequencies.onsets.size()
-                          << " unique onsets, "
-                          << results.component_analysis.frequencies.nuclei.size()
-                          << " unique nuclei, "
-                          << results.component_analysis.frequencies.codas.size()
-                          << " unique codas\n";
+            if (!config.stage_profile_file.empty()) {
+                write_stage_profile(*profiler, config, config.stage_profile_file);
             }
         }
 
-        // Write JSON output
-        if (config.verbose) {
-            std::cout << "\nWriting results to " << config.output_file << "...\n";
-        }
-        write_json_output(results, config.output_file);
-
         if (config.verbose) {
             std::cout << "Done!\n";
         } else {
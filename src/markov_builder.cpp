@@ -1,96 +1,77 @@
 #include "markov_builder.hpp"
-#include <utf8proc.h>
-#include <vector>
 
 namespace nameanalyzer {
 
-// Helper to analyze UTF-8 codepoints
-struct Utf8StringInfo {
-    std::vector<std::size_t> byte_positions;
-    std::size_t num_codepoints;
-};
-
-Utf8StringInfo analyze_utf8_string(const std::string& str) {
-    Utf8StringInfo info;
-    info.byte_positions.push_back(0);
+// Code of the word's end marker. Undecodable trailing bytes stick to it,
+// as they would in the spelled-out "^^" + word + "$" string.
+static std::uint32_t end_marker(const Utf8Word& word, Alphabet& alphabet) {
+    std::string_view trailing = word.trailing_bytes();
+    return trailing.empty() ? alphabet.encode("$") : alphabet.encode(std::string(trailing) + "$");
+}
 
-    std::size_t byte_pos = 0;
-    while (byte_pos < str.size()) {
-        utf8proc_int32_t codepoint;
-        utf8proc_ssize_t bytes_read = utf8proc_iterate(
-            reinterpret_cast<const utf8proc_uint8_t*>(str.data() + byte_pos),
-            static_cast<utf8proc_ssize_t>(str.size() - byte_pos),
-            &codepoint
-        );
+void add_word_to_trie(const Utf8Word& word, const std::vector<std::uint32_t>& codes,
+                      Alphabet& alphabet, ContextTrie& trie, std::size_t weight) {
+    trie.add_sequence(codes, alphabet.encode("^"), end_marker(word, alphabet), weight);
+}
 
-        if (bytes_read <= 0) {
-            byte_pos++;
-            continue;
+void add_word_transitions(const Utf8Word& word, const std::vector<std::uint32_t>& codes,
+                          Alphabet& alphabet, int order, ApproximateCounter& counter,
+                          std::size_t weight) {
+    std::uint32_t pad = alphabet.encode("^");
+    std::uint32_t end = end_marker(word, alphabet);
+    std::size_t back = static_cast<std::size_t>(order);
+
+    std::uint32_t window[max_packed_codes];
+    for (std::size_t j = 0; j <= codes.size(); ++j) {
+        for (std::size_t k = 0; k < back; ++k) {
+            window[k] = j + k >= back ? codes[j + k - back] : pad;
         }
+        window[back] = j < codes.size() ? codes[j] : end;
 
-        byte_pos += static_cast<std::size_t>(bytes_read);
-        info.byte_positions.push_back(byte_pos);
+        std::uint64_t hash = 0;
+        for (std::size_t k = 0; k <= back; ++k) {
+            hash = combine_hash(hash, alphabet.symbol_hash(window[k]));
+        }
+        counter.add(hash, pack_codes(window, order + 1), weight);
     }
-
-    info.num_codepoints = info.byte_positions.size() - 1;
-    return info;
 }
 
-MarkovChain build_markov_chain(const std::vector<std::string>& words, int order) {
-    MarkovChain chain;
+MarkovChain build_markov_chain(const std::vector<std::string>& words, int order, StringPool& strings) {
+    Alphabet alphabet;
+    ContextTrie trie(order);
+    Utf8Word decoded;
+    std::vector<std::uint32_t> codes;
 
     for (const auto& word : words) {
-        // Add start marker for beginning of word
-        std::string augmented = std::string(order, '^') + word + "$";
-
-        Utf8StringInfo utf8_info = analyze_utf8_string(augmented);
-
-        // Build Markov chain using codepoint positions
-        if (utf8_info.num_codepoints <= static_cast<std::size_t>(order)) {
-            continue;  // Not enough characters
-        }
-
-        for (std::size_t i = 0; i < utf8_info.num_codepoints - static_cast<std::size_t>(order); ++i) {
-            // Extract context (order characters)
-            std::size_t context_start_byte = utf8_info.byte_positions[i];
-            std::size_t context_end_byte = utf8_info.byte_positions[i + order];
-            std::string context = augmented.substr(context_start_byte, context_end_byte - context_start_byte);
-
-            // Extract next character
-            std::size_t next_start_byte = utf8_info.byte_positions[i + order];
-            std::size_t next_end_byte = utf8_info.byte_positions[i + order + 1];
-            std::string next_char = augmented.substr(next_start_byte, next_end_byte - next_start_byte);
-
-            chain[context][next_char]++;
-        }
+        decode_utf8(word, decoded);
+        alphabet.encode_word(decoded, codes);
+        add_word_to_trie(decoded, codes, alphabet, trie);
     }
 
+    MarkovChain chain;
+    trie.export_chain(order, alphabet.symbols(), chain, strings);
     return chain;
 }
 
-MarkovChain build_syllable_markov_chain(const std::vector<std::string>& syllables, int order) {
-    // For syllable-level Markov chains, we treat each syllable as a token
-    // This is used when we have a sequence of syllables (from syllable detection)
-
-    MarkovChain chain;
-
-    if (syllables.size() <= static_cast<std::size_t>(order)) {
-        return chain; // Not enough syllables
-    }
-
-    for (std::size_t i = 0; i < syllables.size() - order; ++i) {
-        // Build context from 'order' syllables
-        std::string context;
-        for (int j = 0; j < order; ++j) {
-            if (j > 0) context += "|";
-            context += syllables[i + j];
+MarkovChain build_syllable_markov_chain(const std::vector<std::vector<std::string>>& words, int order,
+                                        StringPool& strings) {
+    // Syllables are tokens with integer IDs; "^" and "$" come first
+    StringTable symbols;
+    std::uint32_t pad = static_cast<std::uint32_t>(symbols.intern("^", strings));
+    std::uint32_t end = static_cast<std::uint32_t>(symbols.intern("$", strings));
+    ContextTrie trie(order);
+    std::vector<std::uint32_t> ids;
+
+    for (const auto& syllables : words) {
+        ids.clear();
+        for (const auto& syll : syllables) {
+            ids.push_back(static_cast<std::uint32_t>(symbols.intern(syll, strings)));
         }
-
-        // Next syllable
-        const std::string& next = syllables[i + order];
-        chain[context][next]++;
+        trie.add_sequence(ids, pad, end);
     }
 
+    MarkovChain chain;
+    trie.export_chain(order, symbols, chain, strings, "|");
     return chain;
 }
 
@@ -1,114 +1,308 @@
 #include "ngram_extractor.hpp"
 #include "markov_builder.hpp"
+#include <algorithm>
 #include <string_view>
-#include <utf8proc.h>
-#include <vector>
 
 namespace nameanalyzer {
 
-// Helper to get UTF-8 codepoint count and byte positions
-struct Utf8Info {
-    std::vector<std::size_t> byte_positions;  // byte_positions[i] = byte offset of i-th codepoint
-    std::size_t num_codepoints;
-};
-
-Utf8Info analyze_utf8(std::string_view str) {
-    Utf8Info info;
-    info.byte_positions.push_back(0);
-
-    std::size_t byte_pos = 0;
-    while (byte_pos < str.size()) {
-        utf8proc_int32_t codepoint;
-        utf8proc_ssize_t bytes_read = utf8proc_iterate(
-            reinterpret_cast<const utf8proc_uint8_t*>(str.data() + byte_pos),
-            static_cast<utf8proc_ssize_t>(str.size() - byte_pos),
-            &codepoint
-        );
-
-        if (bytes_read <= 0) {
-            byte_pos++;  // Skip invalid byte
-            continue;
-        }
-
-        byte_pos += static_cast<std::size_t>(bytes_read);
-        info.byte_positions.push_back(byte_pos);
+void extract_ngrams(const Utf8Word& word, int n, FrequencyMap& ngrams, StringPool& strings) {
+    std::size_t num_codepoints = word.size();
+    if (static_cast<int>(num_codepoints) < n) {
+        return;
     }
 
-    info.num_codepoints = info.byte_positions.size() - 1;
-    return info;
+    // Extract n-grams using codepoint positions
+    for (std::size_t i = 0; i <= num_codepoints - static_cast<std::size_t>(n); ++i) {
+        add_count(ngrams, strings, word.slice(i, i + n));
+    }
 }
 
-void extract_ngrams(std::string_view word, int n, FrequencyMap& ngrams) {
-    Utf8Info utf8_info = analyze_utf8(word);
+void extract_ngrams(std::string_view word, int n, FrequencyMap& ngrams, StringPool& strings) {
+    Utf8Word decoded;
+    decode_utf8(word, decoded);
+    extract_ngrams(decoded, n, ngrams, strings);
+}
 
-    if (static_cast<int>(utf8_info.num_codepoints) < n) {
+void extract_positional_ngrams(const Utf8Word& word, int n, PositionalFrequencies& pos_freq,
+                               StringPool& strings) {
+    std::size_t num_codepoints = word.size();
+    if (static_cast<int>(num_codepoints) < n) {
         return;
     }
 
-    // Extract n-grams using codepoint positions
-    for (std::size_t i = 0; i <= utf8_info.num_codepoints - static_cast<std::size_t>(n); ++i) {
-        std::size_t start_byte = utf8_info.byte_positions[i];
-        std::size_t end_byte = utf8_info.byte_positions[i + n];
-        std::string ngram(word.substr(start_byte, end_byte - start_byte));
-        ngrams[ngram]++;
+    // Start: first n-gram
+    add_count(pos_freq.start, strings, word.slice(0, n));
+
+    // End: last n-gram
+    add_count(pos_freq.end, strings, word.slice(num_codepoints - n, num_codepoints));
+
+    // Middle: all n-grams except first and last
+    if (num_codepoints > static_cast<std::size_t>(n)) {
+        for (std::size_t i = 1; i < num_codepoints - static_cast<std::size_t>(n); ++i) {
+            add_count(pos_freq.middle, strings, word.slice(i, i + n));
+        }
     }
 }
 
-void extract_positional_ngrams(std::string_view word, int n, PositionalFrequencies& pos_freq) {
-    Utf8Info utf8_info = analyze_utf8(word);
+void extract_positional_ngrams(std::string_view word, int n, PositionalFrequencies& pos_freq,
+                               StringPool& strings) {
+    Utf8Word decoded;
+    decode_utf8(word, decoded);
+    extract_positional_ngrams(decoded, n, pos_freq, strings);
+}
+
+// Failure probability of the approximate counters' error bound
+static constexpr double approximate_delta = 0.01;
 
-    if (static_cast<int>(utf8_info.num_codepoints) < n) {
+// Whether the top-order transitions are sketched: a transition is packed
+// into one item, so higher orders are counted exactly in the trie
+static bool sketches_markov(int order, double approximate_epsilon) {
+    return approximate_epsilon > 0.0 && order > 0 && order < max_packed_codes;
+}
+
+LetterCounts::LetterCounts(int order, double approximate_epsilon)
+    : markov(sketches_markov(order, approximate_epsilon) ? order - 1 : order), markov_order(order) {
+    if (approximate_epsilon > 0.0) {
+        approximate_fourgrams.emplace(approximate_epsilon, approximate_delta);
+        if (sketches_markov(order, approximate_epsilon)) {
+            approximate_markov.emplace(approximate_epsilon, approximate_delta);
+        }
+    }
+}
+
+void LetterCounts::clear() {
+    alphabet = Alphabet{};
+    unigrams.clear();
+    bigrams = CountTable{};
+    trigrams = CountTable{};
+    fourgrams = CountTable{};
+    positional_bigrams = PositionalCounts{};
+    positional_trigrams = PositionalCounts{};
+    markov = ContextTrie(markov.max_order());
+    if (approximate_fourgrams) {
+        approximate_fourgrams->clear();
+    }
+    if (approximate_markov) {
+        approximate_markov->clear();
+    }
+}
+
+static void count_positional(const std::vector<std::uint32_t>& codes, int n, PositionalCounts& counts,
+                             std::size_t weight) {
+    std::size_t num_codepoints = codes.size();
+    if (static_cast<int>(num_codepoints) < n) {
         return;
     }
 
-    // Start: first n-gram
-    {
-        std::size_t start_byte = utf8_info.byte_positions[0];
-        std::size_t end_byte = utf8_info.byte_positions[n];
-        std::string start_ngram(word.substr(start_byte, end_byte - start_byte));
-        pos_freq.start[start_ngram]++;
+    counts.start.add(pack_codes(codes.data(), n), weight);
+    counts.end.add(pack_codes(codes.data() + num_codepoints - n, n), weight);
+    for (std::size_t i = 1; i + n < num_codepoints; ++i) {
+        counts.middle.add(pack_codes(codes.data() + i, n), weight);
     }
+}
 
-    // End: last n-gram
-    {
-        std::size_t start_idx = utf8_info.num_codepoints - static_cast<std::size_t>(n);
-        std::size_t start_byte = utf8_info.byte_positions[start_idx];
-        std::size_t end_byte = utf8_info.byte_positions[utf8_info.num_codepoints];
-        std::string end_ngram(word.substr(start_byte, end_byte - start_byte));
-        pos_freq.end[end_ngram]++;
+void count_letters(const Utf8Word& word, LetterCounts& counts, std::vector<std::uint32_t>& codes,
+                   std::size_t weight) {
+    counts.alphabet.encode_word(word, codes);
+
+    for (std::uint32_t code : codes) {
+        if (code >= counts.unigrams.size()) {
+            counts.unigrams.resize(code + 1);
+        }
+        counts.unigrams[code] += weight;
     }
 
-    // Middle: all n-grams except first and last
-    if (utf8_info.num_codepoints > static_cast<std::size_t>(n)) {
-        for (std::size_t i = 1; i < utf8_info.num_codepoints - static_cast<std::size_t>(n); ++i) {
-            std::size_t start_byte = utf8_info.byte_positions[i];
-            std::size_t end_byte = utf8_info.byte_positions[i + n];
-            std::string mid_ngram(word.substr(start_byte, end_byte - start_byte));
-            pos_freq.middle[mid_ngram]++;
+    CountTable* tables[] = {&counts.bigrams, &counts.trigrams, &counts.fourgrams};
+    int exact_up_to = counts.approximate_fourgrams ? 3 : 4;
+    for (int n = 2; n <= exact_up_to; ++n) {
+        for (std::size_t i = 0; i + n <= codes.size(); ++i) {
+            tables[n - 2]->add(pack_codes(codes.data() + i, n), weight);
+        }
+    }
+    if (counts.approximate_fourgrams) {
+        for (std::size_t i = 0; i + 4 <= codes.size(); ++i) {
+            std::uint64_t hash = 0;
+            for (std::size_t j = i; j < i + 4; ++j) {
+                hash = combine_hash(hash, counts.alphabet.symbol_hash(codes[j]));
+            }
+            counts.approximate_fourgrams->add(hash, pack_codes(codes.data() + i, 4), weight);
         }
     }
+
+    count_positional(codes, 2, counts.positional_bigrams, weight);
+    count_positional(codes, 3, counts.positional_trigrams, weight);
+
+    add_word_to_trie(word, codes, counts.alphabet, counts.markov, weight);
+    if (counts.approximate_markov) {
+        add_word_transitions(word, codes, counts.alphabet, counts.markov_order, *counts.approximate_markov,
+                             weight);
+    }
 }
 
-LetterAnalysis analyze_letters(const std::vector<std::string>& words, int markov_order) {
-    LetterAnalysis analysis;
+static void merge_table(CountTable& dst, const CountTable& src, int n,
+                        const std::vector<std::uint32_t>& remap) {
+    std::uint32_t codes[max_packed_codes];
+    src.for_each([&](std::uint64_t key, std::size_t count) {
+        unpack_codes(key, n, codes);
+        for (int i = 0; i < n; ++i) {
+            codes[i] = remap[codes[i]];
+        }
+        dst.add(pack_codes(codes, n), count);
+    });
+}
 
-    for (const auto& word : words) {
-        // Extract n-grams of various sizes
-        extract_ngrams(word, 1, analysis.unigrams);
-        extract_ngrams(word, 2, analysis.bigrams);
-        extract_ngrams(word, 3, analysis.trigrams);
-        extract_ngrams(word, 4, analysis.fourgrams);
+static void merge_positional_counts(PositionalCounts& dst, const PositionalCounts& src, int n,
+                                    const std::vector<std::uint32_t>& remap) {
+    merge_table(dst.start, src.start, n, remap);
+    merge_table(dst.middle, src.middle, n, remap);
+    merge_table(dst.end, src.end, n, remap);
+}
+
+void merge_letter_counts(LetterCounts& dst, const LetterCounts& src) {
+    std::vector<std::uint32_t> remap(src.alphabet.size());
+    for (std::uint32_t code = 0; code < remap.size(); ++code) {
+        remap[code] = dst.alphabet.encode(src.alphabet.symbol(code));
+    }
 
-        // Extract positional n-grams
-        extract_positional_ngrams(word, 2, analysis.positional_bigrams);
-        extract_positional_ngrams(word, 3, analysis.positional_trigrams);
+    for (std::uint32_t code = 0; code < src.unigrams.size(); ++code) {
+        if (remap[code] >= dst.unigrams.size()) {
+            dst.unigrams.resize(remap[code] + 1);
+        }
+        dst.unigrams[remap[code]] += src.unigrams[code];
     }
 
-    // Build Markov chains for requested orders (1 to markov_order)
+    merge_table(dst.bigrams, src.bigrams, 2, remap);
+    merge_table(dst.trigrams, src.trigrams, 3, remap);
+    merge_table(dst.fourgrams, src.fourgrams, 4, remap);
+    merge_positional_counts(dst.positional_bigrams, src.positional_bigrams, 2, remap);
+    merge_positional_counts(dst.positional_trigrams, src.positional_trigrams, 3, remap);
+    dst.markov.merge(src.markov, remap);
+
+    // Approximate counters sketch alphabet-independent hashes; only the
+    // kept items need translating
+    auto remap_item = [&remap](std::uint64_t item, int n) {
+        std::uint32_t codes[max_packed_codes];
+        unpack_codes(item, n, codes);
+        for (int i = 0; i < n; ++i) {
+            codes[i] = remap[codes[i]];
+        }
+        return pack_codes(codes, n);
+    };
+    if (dst.approximate_fourgrams && src.approximate_fourgrams) {
+        dst.approximate_fourgrams->merge(*src.approximate_fourgrams,
+                                         [&](std::uint64_t item) { return remap_item(item, 4); });
+    }
+    if (dst.approximate_markov && src.approximate_markov) {
+        int n = dst.markov_order + 1;
+        dst.approximate_markov->merge(*src.approximate_markov,
+                                      [&](std::uint64_t item) { return remap_item(item, n); });
+    }
+}
+
+static void prune_positional_counts(PositionalCounts& counts, std::size_t threshold) {
+    counts.start.prune_lossy(threshold);
+    counts.middle.prune_lossy(threshold);
+    counts.end.prune_lossy(threshold);
+}
+
+void prune_letter_counts(LetterCounts& counts, std::size_t threshold) {
+    counts.bigrams.prune_lossy(threshold);
+    counts.trigrams.prune_lossy(threshold);
+    counts.fourgrams.prune_lossy(threshold);
+    prune_positional_counts(counts.positional_bigrams, threshold);
+    prune_positional_counts(counts.positional_trigrams, threshold);
+    counts.markov.prune(threshold);
+}
+
+static void export_table(const CountTable& table, int n, const Alphabet& alphabet, FrequencyMap& ngrams,
+                         StringPool& strings) {
+    // Spell out and sort the keys first so the map can be filled in order
+    std::vector<std::pair<std::string, std::size_t>> entries;
+    entries.reserve(table.size());
+    std::uint32_t codes[max_packed_codes];
+    table.for_each([&](std::uint64_t key, std::size_t count) {
+        unpack_codes(key, n, codes);
+        std::string ngram;
+        for (int i = 0; i < n; ++i) {
+            ngram += alphabet.symbol(codes[i]);
+        }
+        entries.emplace_back(std::move(ngram), count);
+    });
+    std::sort(entries.begin(), entries.end());
+
+    for (const auto& [ngram, count] : entries) {
+        auto it = ngrams.lower_bound(ngram);
+        if (it != ngrams.end() && it->first == ngram) {
+            it->second += count;
+        } else {
+            ngrams.emplace_hint(it, strings.intern(ngram), count);
+        }
+    }
+}
+
+static void export_positional(const PositionalCounts& counts, int n, const Alphabet& alphabet,
+                              PositionalFrequencies& pos_freq, StringPool& strings) {
+    export_table(counts.start, n, alphabet, pos_freq.start, strings);
+    export_table(counts.middle, n, alphabet, pos_freq.middle, strings);
+    export_table(counts.end, n, alphabet, pos_freq.end, strings);
+}
+
+void export_letter_counts(const LetterCounts& counts, LetterAnalysis& analysis, StringPool& strings) {
+    for (std::uint32_t code = 0; code < counts.unigrams.size(); ++code) {
+        if (counts.unigrams[code] > 0) {
+            add_count(analysis.unigrams, strings, counts.alphabet.symbol(code), counts.unigrams[code]);
+        }
+    }
+
+    const Alphabet& alphabet = counts.alphabet;
+    export_table(counts.bigrams, 2, alphabet, analysis.bigrams, strings);
+    export_table(counts.trigrams, 3, alphabet, analysis.trigrams, strings);
+    export_table(counts.fourgrams, 4, alphabet, analysis.fourgrams, strings);
+    export_positional(counts.positional_bigrams, 2, alphabet, analysis.positional_bigrams, strings);
+    export_positional(counts.positional_trigrams, 3, alphabet, analysis.positional_trigrams, strings);
+    counts.markov.export_chains(alphabet.symbols(), analysis.markov_chains, strings);
+
+    std::uint32_t codes[max_packed_codes];
+    if (counts.approximate_fourgrams) {
+        counts.approximate_fourgrams->for_each([&](std::uint64_t item, std::size_t count) {
+            unpack_codes(item, 4, codes);
+            std::string ngram;
+            for (int i = 0; i < 4; ++i) {
+                ngram += counts.alphabet.symbol(codes[i]);
+            }
+            add_count(analysis.fourgrams, strings, ngram, count);
+        });
+    }
+    if (counts.approximate_markov) {
+        int order = counts.markov_order;
+        MarkovChain& chain = analysis.markov_chains[order];
+        counts.approximate_markov->for_each([&](std::uint64_t item, std::size_t count) {
+            unpack_codes(item, order + 1, codes);
+            std::string context;
+            for (int i = 0; i < order; ++i) {
+                context += counts.alphabet.symbol(codes[i]);
+            }
+            add_count(context_counts(chain, strings, context), strings, counts.alphabet.symbol(codes[order]),
+                      count);
+        });
+    }
+}
+
+LetterAnalysis analyze_letters(const std::vector<std::string>& words, int markov_order, StringPool& strings) {
+    LetterAnalysis analysis;
     for (int order = 1; order <= markov_order; ++order) {
-        analysis.markov_chains[order] = build_markov_chain(words, order);
+        analysis.markov_chains[order];
+    }
+
+    LetterCounts counts(markov_order);
+    Utf8Word decoded;
+    std::vector<std::uint32_t> codes;
+    for (const auto& word : words) {
+        decode_utf8(word, decoded);
+        count_letters(decoded, counts, codes);
     }
 
+    export_letter_counts(counts, analysis, strings);
     return analysis;
 }
 
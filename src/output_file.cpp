@@ -0,0 +1,120 @@
+#include "output_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace nameanalyzer {
+
+void OutputFile::write(std::string_view data) {
+    while (!data.empty()) {
+        if (used_ == buffer_.size()) {
+            flush();
+        }
+        std::size_t n = std::min(data.size(), buffer_.size() - used_);
+        std::memcpy(buffer_.data() + used_, data.data(), n);
+        used_ += n;
+        data.remove_prefix(n);
+    }
+}
+
+#if defined(_WIN32)
+
+OutputFile::OutputFile(const std::string& filename, std::size_t buffer_size)
+    : filename_(filename), buffer_(std::max<std::size_t>(buffer_size, 1)) {
+    file_.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+}
+
+OutputFile::~OutputFile() {
+    if (file_.is_open()) {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+    }
+}
+
+void OutputFile::flush() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+    used_ = 0;
+    if (!file_) {
+        throw std::runtime_error("Failed to write output file: " + filename_);
+    }
+}
+
+void OutputFile::close() {
+    if (!file_.is_open()) {
+        return;
+    }
+    flush();
+    file_.close();
+    if (!file_) {
+        throw std::runtime_error("Failed to write output file: " + filename_);
+    }
+}
+
+#else
+
+OutputFile::OutputFile(const std::string& filename, std::size_t buffer_size)
+    : filename_(filename), buffer_(std::max<std::size_t>(buffer_size, 1)) {
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+}
+
+OutputFile::~OutputFile() {
+    if (fd_ >= 0) {
+        try {
+            flush();
+        } catch (...) {
+        }
+        ::close(fd_);
+    }
+}
+
+void OutputFile::flush() {
+    const char* data = buffer_.data();
+    std::size_t remaining = used_;
+    used_ = 0;
+    while (remaining > 0) {
+        ssize_t written = ::write(fd_, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write output file: " + filename_ + ": " +
+                                     std::strerror(errno));
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+}
+
+void OutputFile::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    try {
+        flush();
+    } catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+    int result = ::close(fd_);
+    fd_ = -1;
+    if (result != 0) {
+        throw std::runtime_error("Failed to write output file: " + filename_ + ": " +
+                                 std::strerror(errno));
+    }
+}
+
+#endif
+
+} // namespace nameanalyzer
@@ -0,0 +1,95 @@
+#include "profile_index.hpp"
+#include <algorithm>
+
+namespace nameanalyzer {
+
+// Rank counts, indexing the keys only if asked to; most contexts are only
+// ever listed
+static RankedCounts rank(const FrequencyMap& counts, bool indexed) {
+    RankedCounts ranked;
+    ranked.entries.reserve(counts.size());
+    for (const auto& [key, count] : counts) {
+        ranked.entries.emplace_back(key, count);
+        ranked.total += count;
+    }
+    // Map order is key order, so a stable sort breaks ties by key
+    std::stable_sort(ranked.entries.begin(), ranked.entries.end(),
+                     [](const auto& a, const auto& b) { return a.second > b.second; });
+    if (indexed) {
+        ranked.positions.reserve(ranked.entries.size());
+        for (std::size_t i = 0; i < ranked.entries.size(); ++i) {
+            ranked.positions.emplace(ranked.entries[i].first, i);
+        }
+    }
+    return ranked;
+}
+
+std::pair<std::size_t, std::size_t> RankedCounts::find(std::string_view key) const {
+    auto it = positions.find(key);
+    if (it == positions.end()) {
+        return {0, 0};
+    }
+    return {entries[it->second].second, it->second + 1};
+}
+
+static void add_contexts(const std::map<int, MarkovChain>& chains,
+                         std::unordered_map<std::string_view, RankedCounts>& contexts) {
+    for (const auto& [order, chain] : chains) {
+        for (const auto& [context, next] : chain) {
+            contexts.emplace(context, rank(next, false));
+        }
+    }
+}
+
+ProfileIndex::ProfileIndex(AnalysisResults results) : results_(std::move(results)) {
+    const LetterAnalysis& letters = results_.letter_analysis;
+    add_table("unigrams", letters.unigrams);
+    add_table("bigrams", letters.bigrams);
+    add_table("trigrams", letters.trigrams);
+    add_table("fourgrams", letters.fourgrams);
+
+    auto add_positional = [this](const std::string& name, const PositionalFrequencies& positional) {
+        add_table(name + ".start", positional.start);
+        add_table(name + ".middle", positional.middle);
+        add_table(name + ".end", positional.end);
+    };
+    add_positional("bigrams", letters.positional_bigrams);
+    add_positional("trigrams", letters.positional_trigrams);
+    add_contexts(letters.markov_chains, letter_contexts_);
+
+    if (results_.config.enable_syllables) {
+        const SyllableAnalysis& syllables = results_.syllable_analysis;
+        add_table("syllables", syllables.syllable_frequencies);
+        add_positional("syllables", syllables.positional_syllables);
+        add_contexts(syllables.syllable_markov, syllable_contexts_);
+    }
+    if (results_.config.enable_components) {
+        const ComponentAnalysis& components = results_.component_analysis;
+        add_table("onsets", components.frequencies.onsets);
+        add_table("nuclei", components.frequencies.nuclei);
+        add_table("codas", components.frequencies.codas);
+        add_positional("onsets", components.positional_onsets);
+        add_positional("codas", components.positional_codas);
+    }
+}
+
+void ProfileIndex::add_table(std::string name, const FrequencyMap& counts) {
+    tables_.emplace(std::move(name), rank(counts, true));
+}
+
+const RankedCounts* ProfileIndex::table(std::string_view name) const {
+    auto it = tables_.find(name);
+    return it == tables_.end() ? nullptr : &it->second;
+}
+
+const RankedCounts* ProfileIndex::next_letter(std::string_view context) const {
+    auto it = letter_contexts_.find(context);
+    return it == letter_contexts_.end() ? nullptr : &it->second;
+}
+
+const RankedCounts* ProfileIndex::next_syllable(std::string_view context) const {
+    auto it = syllable_contexts_.find(context);
+    return it == syllable_contexts_.end() ? nullptr : &it->second;
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,160 @@
+#include "profile_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+namespace format = profile_format;
+
+namespace {
+
+[[noreturn]] void corrupt(const std::string& what) {
+    throw std::runtime_error("Corrupt binary profile: " + what);
+}
+
+/// Check that count elements of type T at offset lie inside the file and
+/// are aligned for T
+template <typename T>
+const T* array_at(std::string_view file, std::uint64_t offset, std::uint64_t count) {
+    if (offset > file.size() || count > (file.size() - offset) / sizeof(T)) {
+        corrupt("section out of bounds");
+    }
+    const char* data = file.data() + offset;
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) {
+        corrupt("misaligned section");
+    }
+    return reinterpret_cast<const T*>(data);
+}
+
+} // namespace
+
+std::string_view ProfileRow::context() const {
+    return profile_->string(context_);
+}
+
+std::string_view ProfileRow::symbol(std::size_t index) const {
+    return profile_->string(symbols_[index]);
+}
+
+std::size_t ProfileRow::sample_index(std::uint64_t value) const {
+    if (size_ == 0) {
+        throw std::out_of_range("Cannot sample from an empty profile row");
+    }
+    const std::uint64_t* found = std::upper_bound(cumulative_, cumulative_ + size_, value);
+    return std::min(static_cast<std::size_t>(found - cumulative_), size_ - 1);
+}
+
+std::string_view ProfileTable::name() const {
+    return profile_->string(record_->name);
+}
+
+ProfileRow ProfileTable::row(std::size_t index) const {
+    if (index >= record_->row_count) {
+        throw std::out_of_range("Profile row index out of range");
+    }
+    std::uint32_t first = row_starts_[index];
+    std::uint32_t last = row_starts_[index + 1];
+    if (first > last || last > record_->entry_count) {
+        corrupt("row bounds");
+    }
+
+    ProfileRow row;
+    row.profile_ = profile_;
+    row.context_ = row_keys_[index];
+    row.symbols_ = symbols_ + first;
+    row.cumulative_ = cumulative_ + first;
+    row.size_ = last - first;
+    return row;
+}
+
+std::optional<ProfileRow> ProfileTable::find(std::string_view context) const {
+    const std::uint32_t* keys_end = row_keys_ + record_->row_count;
+    const std::uint32_t* found = std::lower_bound(
+        row_keys_, keys_end, context,
+        [this](std::uint32_t key, std::string_view target) { return profile_->string(key) < target; });
+    if (found == keys_end || profile_->string(*found) != context) {
+        return std::nullopt;
+    }
+    return row(static_cast<std::size_t>(found - row_keys_));
+}
+
+ProfileReader::ProfileReader(const std::string& filename) : file_(filename) {
+    std::string_view file = file_.contents();
+    if (file.size() < sizeof(format::ProfileHeader) ||
+        std::memcmp(file.data(), format::magic, sizeof(format::magic)) != 0) {
+        throw std::runtime_error("Not a binary profile: " + filename);
+    }
+    header_ = array_at<format::ProfileHeader>(file, 0, 1);
+    if (header_->version != format::version) {
+        throw std::runtime_error("Unsupported binary profile version " +
+                                 std::to_string(header_->version) + ": " + filename);
+    }
+    if (header_->byte_order_mark != format::byte_order_mark) {
+        throw std::runtime_error("Binary profile was written with a different byte order: " + filename);
+    }
+    if (header_->file_size != file.size()) {
+        corrupt("file size does not match header (truncated?)");
+    }
+
+    tables_ = array_at<format::TableRecord>(file, header_->tables_offset, header_->table_count);
+    string_offsets_ = array_at<std::uint64_t>(file, header_->string_offsets_offset,
+                                              std::uint64_t(header_->string_count) + 1);
+    string_bytes_ = string_offsets_[header_->string_count];
+    string_data_ = array_at<char>(file, header_->string_data_offset, string_bytes_);
+
+    for (std::size_t i = 0; i < header_->table_count; ++i) {
+        const format::TableRecord& record = tables_[i];
+        if (record.name >= header_->string_count) {
+            corrupt("table name");
+        }
+        array_at<std::uint32_t>(file, record.row_keys_offset, record.row_count);
+        array_at<std::uint32_t>(file, record.row_starts_offset, std::uint64_t(record.row_count) + 1);
+        array_at<std::uint32_t>(file, record.entry_symbols_offset, record.entry_count);
+        array_at<std::uint64_t>(file, record.entry_cumulative_offset, record.entry_count);
+    }
+}
+
+std::string_view ProfileReader::string(std::uint32_t id) const {
+    if (id >= header_->string_count) {
+        corrupt("string index");
+    }
+    std::uint64_t first = string_offsets_[id];
+    std::uint64_t last = string_offsets_[id + 1];
+    if (first > last || last > string_bytes_) {
+        corrupt("string bounds");
+    }
+    return {string_data_ + first, static_cast<std::size_t>(last - first)};
+}
+
+ProfileTable ProfileReader::table(std::size_t index) const {
+    if (index >= header_->table_count) {
+        throw std::out_of_range("Profile table index out of range");
+    }
+    const format::TableRecord& record = tables_[index];
+    const char* base = file_.contents().data();
+
+    ProfileTable table;
+    table.profile_ = this;
+    table.record_ = &record;
+    table.row_keys_ = reinterpret_cast<const std::uint32_t*>(base + record.row_keys_offset);
+    table.row_starts_ = reinterpret_cast<const std::uint32_t*>(base + record.row_starts_offset);
+    table.symbols_ = reinterpret_cast<const std::uint32_t*>(base + record.entry_symbols_offset);
+    table.cumulative_ = reinterpret_cast<const std::uint64_t*>(base + record.entry_cumulative_offset);
+    return table;
+}
+
+std::optional<ProfileTable> ProfileReader::find_table(std::string_view name) const {
+    const format::TableRecord* tables_end = tables_ + header_->table_count;
+    const format::TableRecord* found = std::lower_bound(
+        tables_, tables_end, name,
+        [this](const format::TableRecord& record, std::string_view target) {
+            return string(record.name) < target;
+        });
+    if (found == tables_end || string(found->name) != name) {
+        return std::nullopt;
+    }
+    return table(static_cast<std::size_t>(found - tables_));
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,412 @@
+#include "profile_server.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace nameanalyzer {
+
+std::size_t LatencyHistogram::bucket_of(std::uint64_t ns) {
+    if (ns < sub_buckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    // Exponent picks the power of two, the next three bits the step within it
+    std::size_t exponent = static_cast<std::size_t>(std::bit_width(ns)) - 1;
+    return (exponent - 2) * sub_buckets + static_cast<std::size_t>((ns >> (exponent - 3)) & (sub_buckets - 1));
+}
+
+std::uint64_t LatencyHistogram::bucket_limit(std::size_t bucket) {
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    std::size_t exponent = bucket / sub_buckets + 2;
+    std::uint64_t step = bucket % sub_buckets;
+    return ((sub_buckets + step + 1) << (exponent - 3)) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+    counts_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::count() const {
+    std::uint64_t total = 0;
+    for (const auto& count : counts_) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double LatencyHistogram::percentile_us(double q) const {
+    std::uint64_t total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+    auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * static_cast<double>(total) + 0.5));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < num_buckets; ++bucket) {
+        seen += counts_[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // The bucket's limit, but never beyond the largest latency seen
+            return std::min(static_cast<double>(bucket_limit(bucket)) / 1000.0, max_us());
+        }
+    }
+    return max_us();
+}
+
+std::string LatencyHistogram::summary() const {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "queries %llu p50 %.2f p90 %.2f p99 %.2f p999 %.2f max %.2f",
+                  static_cast<unsigned long long>(count()), percentile_us(0.5), percentile_us(0.9),
+                  percentile_us(0.99), percentile_us(0.999), max_us());
+    return buffer;
+}
+
+namespace {
+
+void append_number(std::string& out, std::size_t number) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+// Keys are never empty on the wire, which would shift the fields
+void append_key(std::string& out, std::string_view key) {
+    out += key.empty() ? std::string_view("\"\"") : key;
+}
+
+std::string_view decode_key(std::string_view token) {
+    return token == "\"\"" ? std::string_view() : token;
+}
+
+// Split a request on spaces and tabs; returns false if it has too many fields
+bool split_fields(std::string_view request, std::string_view (&fields)[4], std::size_t& count) {
+    count = 0;
+    std::size_t pos = 0;
+    while (true) {
+        std::size_t start = request.find_first_not_of(" \t", pos);
+        if (start == std::string_view::npos) {
+            return true;
+        }
+        if (count == std::size(fields)) {
+            return false;
+        }
+        std::size_t end = std::min(request.find_first_of(" \t", start), request.size());
+        fields[count++] = request.substr(start, end - start);
+        pos = end;
+    }
+}
+
+// Append "ok <total>" and the first k entries
+void append_list(std::string& out, const RankedCounts* ranked, std::size_t k) {
+    out += "ok ";
+    if (ranked == nullptr) {
+        out += '0';
+        return;
+    }
+    append_number(out, ranked->total);
+    std::size_t shown = std::min(k, ranked->entries.size());
+    for (std::size_t i = 0; i < shown; ++i) {
+        out += ' ';
+        append_key(out, ranked->entries[i].first);
+        out += ' ';
+        append_number(out, ranked->entries[i].second);
+    }
+}
+
+} // namespace
+
+void answer_query(const ProfileIndex& index, const LatencyHistogram& latency, std::string_view request,
+                  std::string& out) {
+    std::string_view fields[4];
+    std::size_t count = 0;
+    auto fail = [&out](std::string_view message) {
+        out += "err ";
+        out += message;
+        out += '\n';
+    };
+    if (!split_fields(request, fields, count)) {
+        return fail("too many fields");
+    }
+    if (count == 0) {
+        return fail("empty request");
+    }
+
+    std::string_view command = fields[0];
+    // Optional list length in fields[2]
+    std::size_t k = static_cast<std::size_t>(-1);
+    auto parse_k = [&]() {
+        if (count < 3) {
+            return true;
+        }
+        auto result = std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), k);
+        return result.ec == std::errc() && result.ptr == fields[2].data() + fields[2].size();
+    };
+
+    if (command == "next" || command == "snext" || command == "top") {
+        if (count < 2) {
+            return fail("missing argument");
+        }
+        if (!parse_k()) {
+            return fail("invalid count");
+        }
+        const RankedCounts* ranked = nullptr;
+        if (command == "next") {
+            ranked = index.next_letter(fields[1]);
+        } else if (command == "snext") {
+            ranked = index.next_syllable(fields[1]);
+        } else if ((ranked = index.table(fields[1])) == nullptr) {
+            return fail("unknown table");
+        }
+        append_list(out, ranked, k);
+    } else if (command == "count") {
+        if (count != 3) {
+            return fail("expected: count <table> <key>");
+        }
+        const RankedCounts* table = index.table(fields[1]);
+        if (table == nullptr) {
+            return fail("unknown table");
+        }
+        auto [found, rank] = table->find(decode_key(fields[2]));
+        out += "ok ";
+        append_number(out, found);
+        out += ' ';
+        append_number(out, table->total);
+        out += ' ';
+        append_number(out, rank);
+    } else if (command == "stats") {
+        const CorpusStats& stats = index.results().stats;
+        out += "ok words ";
+        append_number(out, stats.total_words);
+        out += " characters ";
+        append_number(out, stats.total_characters);
+        out += " syllables ";
+        append_number(out, stats.total_syllables);
+    } else if (command == "latency") {
+        out += "ok ";
+        out += latency.summary();
+    } else {
+        return fail("unknown request");
+    }
+    out += '\n';
+}
+
+#if defined(_WIN32)
+
+void serve_profile(const ProfileIndex&, const std::string&, bool) {
+    throw std::runtime_error("serve needs Unix domain sockets, which this platform does not provide");
+}
+
+#else
+
+namespace {
+
+// Longest request line accepted; anything longer is not a query
+constexpr std::size_t max_request_bytes = 64 * 1024;
+
+// Open client sockets, so shutdown can wake the threads blocked on them
+struct Connections {
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::unordered_set<int> fds;
+};
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+void serve_client(int fd, const ProfileIndex& index, LatencyHistogram& latency, Connections& connections) {
+    std::string pending;
+    std::string out;
+    char buffer[64 * 1024];
+    bool open = true;
+    while (open) {
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, static_cast<std::size_t>(received));
+
+        // Answer every complete line of the batch, then reply in one write
+        out.clear();
+        std::size_t start = 0;
+        std::size_t end;
+        while (open && (end = pending.find('\n', start)) != std::string::npos) {
+            std::string_view request(pending.data() + start, end - start);
+            start = end + 1;
+            if (!request.empty() && request.back() == '\r') {
+                request.remove_suffix(1);
+            }
+            if (request == "quit") {
+                open = false;
+                break;
+            }
+            auto begin = std::chrono::steady_clock::now();
+            answer_query(index, latency, request, out);
+            latency.record(std::chrono::steady_clock::now() - begin);
+        }
+        pending.erase(0, start);
+        if (pending.size() > max_request_bytes) {
+            out += "err request too long\n";
+            open = false;
+        }
+        if (!write_all(fd, out)) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(connections.mutex);
+    connections.fds.erase(fd);
+    ::close(fd);
+    connections.idle.notify_all();
+}
+
+std::runtime_error socket_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+void serve_profile(const ProfileIndex& index, const std::string& socket_path, bool verbose) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid socket path: " + socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    // Replace a socket left behind by an earlier server, but nothing else
+    struct stat existing;
+    if (::lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw std::runtime_error("Not a socket, refusing to replace: " + socket_path);
+        }
+        ::unlink(socket_path.c_str());
+    }
+
+    // A client that disconnects early is a failed write, not a reason to exit
+    auto previous_pipe_handler = std::signal(SIGPIPE, SIG_IGN);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw socket_error("Cannot create socket", socket_path);
+    }
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listener, SOMAXCONN) < 0) {
+        auto error = socket_error("Cannot listen on", socket_path);
+        ::close(listener);
+        throw error;
+    }
+
+    // SIGINT and SIGTERM go to a thread of their own, which wakes the
+    // accept loop through a pipe; every other thread blocks them
+    int wake[2];
+    if (::pipe(wake) < 0) {
+        ::close(listener);
+        ::unlink(socket_path.c_str());
+        throw socket_error("Cannot create pipe for", socket_path);
+    }
+    sigset_t signals;
+    sigset_t previous_mask;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous_mask);
+    std::thread signal_thread([&signals, &wake] {
+        int signal = 0;
+        sigwait(&signals, &signal);
+        char byte = 0;
+        ssize_t ignored = ::write(wake[1], &byte, 1);
+        (void)ignored;
+    });
+
+    LatencyHistogram latency;
+    Connections connections;
+    std::cout << "Serving on " << socket_path << std::endl;
+
+    pollfd watched[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    while (true) {
+        if (::poll(watched, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (watched[1].revents != 0) {
+            break;
+        }
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        if (verbose) {
+            std::cout << "Client connected\n";
+        }
+        std::lock_guard<std::mutex> lock(connections.mutex);
+        connections.fds.insert(client);
+        std::thread(serve_client, client, std::cref(index), std::ref(latency), std::ref(connections)).detach();
+    }
+
+    // Stop the signal thread if the loop ended for another reason
+    if (watched[1].revents == 0) {
+        pthread_kill(signal_thread.native_handle(), SIGTERM);
+    }
+    signal_thread.join();
+
+    // Wake the clients' threads and wait until all have closed
+    {
+        std::unique_lock<std::mutex> lock(connections.mutex);
+        for (int fd : connections.fds) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        connections.idle.wait(lock, [&connections] { return connections.fds.empty(); });
+    }
+    ::close(listener);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    ::unlink(socket_path.c_str());
+    std::signal(SIGPIPE, previous_pipe_handler);
+
+    std::cout << "Stopped; latency in microseconds: " << latency.summary() << std::endl;
+    // Only now may a second interrupt end the process
+    pthread_sigmask(SIG_SETMASK, &previous_mask, nullptr);
+}
+
+#endif
+
+} // namespace nameanalyzer
@@ -0,0 +1,267 @@
+#include "profile_writer.hpp"
+#include "profile_format.hpp"
+#include "output_file.hpp"
+#include "string_table.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace nameanalyzer {
+
+namespace format = profile_format;
+
+namespace {
+
+constexpr std::uint64_t alignment = 8;
+
+std::uint64_t align_up(std::uint64_t offset) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+std::uint32_t checked_u32(std::size_t value) {
+    if (value > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Profile too large for the binary format");
+    }
+    return static_cast<std::uint32_t>(value);
+}
+
+/// One table in the compressed sparse row form of profile_format.hpp
+struct TableData {
+    std::uint32_t name = 0;
+    std::uint32_t order = 0;
+    std::vector<std::uint32_t> row_keys;
+    std::vector<std::uint32_t> row_starts{0};
+    std::vector<std::uint32_t> symbols;
+    std::vector<std::uint64_t> cumulative;
+    format::TableRecord record{};
+};
+
+/// Collects the tables and string pool of a profile, then lays them out
+class ProfileBuilder {
+public:
+    void add_frequencies(std::string_view name, const FrequencyMap& frequencies) {
+        TableData& table = new_table(name, 0);
+        add_row(table, "", frequencies);
+    }
+
+    void add_positional(std::string_view name, const PositionalFrequencies& positional) {
+        std::string prefix(name);
+        add_frequencies(prefix + ".start", positional.start);
+        add_frequencies(prefix + ".middle", positional.middle);
+        add_frequencies(prefix + ".end", positional.end);
+    }
+
+    void add_markov_chains(std::string_view name, const std::map<int, MarkovChain>& chains) {
+        for (const auto& [order, chain] : chains) {
+            TableData& table = new_table(std::string(name) + ".order_" + std::to_string(order),
+                                         static_cast<std::uint32_t>(order));
+            // MarkovChain is ordered by context, which is the row order the
+            // reader binary-searches
+            for (const auto& [context, next] : chain) {
+                add_row(table, context, next);
+            }
+        }
+    }
+
+    /// A list is stored as a single row in which every item counts once
+    void add_list(std::string_view name, const StringTable& items) {
+        TableData& table = new_table(name, 0);
+        table.row_keys.push_back(intern(""));
+        for (const auto& item : items) {
+            table.symbols.push_back(intern(item));
+            table.cumulative.push_back(table.cumulative.size() + 1);
+        }
+        table.row_starts.push_back(checked_u32(table.symbols.size()));
+    }
+
+    void write(const AnalysisResults& results, const std::string& filename);
+
+private:
+    std::uint32_t intern(std::string_view str) {
+        return checked_u32(strings_.intern(str, pool_));
+    }
+
+    TableData& new_table(std::string_view name, std::uint32_t order) {
+        TableData& table = tables_.emplace_back();
+        table.name = intern(name);
+        table.order = order;
+        return table;
+    }
+
+    void add_row(TableData& table, std::string_view key, const FrequencyMap& frequencies) {
+        table.row_keys.push_back(intern(key));
+        std::uint64_t total = 0;
+        for (const auto& [symbol, count] : frequencies) {
+            total += count;
+            table.symbols.push_back(intern(symbol));
+            table.cumulative.push_back(total);
+        }
+        table.row_starts.push_back(checked_u32(table.symbols.size()));
+    }
+
+    StringPool pool_;
+    StringTable strings_;  // Interned in pool_
+    std::vector<TableData> tables_;
+};
+
+/// OutputFile plus the current file offset, for padding to alignment
+class SectionWriter {
+public:
+    explicit SectionWriter(OutputFile& out) : out_(out) {}
+
+    template <typename T>
+    void write_array(std::uint64_t offset, const T* data, std::size_t count) {
+        pad_to(offset);
+        write_bytes(data, count * sizeof(T));
+    }
+
+    void write_bytes(const void* data, std::size_t size) {
+        out_.write({static_cast<const char*>(data), size});
+        position_ += size;
+    }
+
+    void pad_to(std::uint64_t offset) {
+        if (offset < position_) {
+            throw std::logic_error("Binary profile sections out of order");
+        }
+        while (position_ < offset) {
+            out_.put('\0');
+            ++position_;
+        }
+    }
+
+    std::uint64_t position() const { return position_; }
+
+private:
+    OutputFile& out_;
+    std::uint64_t position_ = 0;
+};
+
+void ProfileBuilder::write(const AnalysisResults& results, const std::string& filename) {
+    // Readers find tables by binary search on their names
+    std::sort(tables_.begin(), tables_.end(), [this](const TableData& a, const TableData& b) {
+        return std::string_view(strings_[a.name]) < std::string_view(strings_[b.name]);
+    });
+
+    // Lay out every section before writing, so the header can go first
+    format::ProfileHeader header{};
+    std::memcpy(header.magic, format::magic, sizeof(header.magic));
+    header.version = format::version;
+    header.byte_order_mark = format::byte_order_mark;
+    header.string_count = checked_u32(strings_.size());
+    header.table_count = checked_u32(tables_.size());
+
+    std::uint64_t offset = sizeof(format::ProfileHeader);
+    header.tables_offset = offset;
+    offset += tables_.size() * sizeof(format::TableRecord);
+
+    std::vector<std::uint64_t> string_offsets;
+    string_offsets.reserve(strings_.size() + 1);
+    std::uint64_t string_bytes = 0;
+    string_offsets.push_back(0);
+    for (const auto& str : strings_) {
+        string_bytes += str.size();
+        string_offsets.push_back(string_bytes);
+    }
+    header.string_offsets_offset = offset;
+    offset += string_offsets.size() * sizeof(std::uint64_t);
+    header.string_data_offset = offset;
+    offset += string_bytes;
+
+    for (TableData& table : tables_) {
+        format::TableRecord& record = table.record;
+        record.name = table.name;
+        record.order = table.order;
+        record.row_count = checked_u32(table.row_keys.size());
+        record.entry_count = checked_u32(table.symbols.size());
+
+        record.row_keys_offset = align_up(offset);
+        offset = record.row_keys_offset + table.row_keys.size() * sizeof(std::uint32_t);
+        record.row_starts_offset = align_up(offset);
+        offset = record.row_starts_offset + table.row_starts.size() * sizeof(std::uint32_t);
+        record.entry_symbols_offset = align_up(offset);
+        offset = record.entry_symbols_offset + table.symbols.size() * sizeof(std::uint32_t);
+        record.entry_cumulative_offset = align_up(offset);
+        offset = record.entry_cumulative_offset + table.cumulative.size() * sizeof(std::uint64_t);
+    }
+    header.file_size = offset;
+
+    const Config& config = results.config;
+    header.markov_order = config.markov_order;
+    header.min_word_length = config.min_word_length;
+    header.flags = (config.enable_syllables ? format::syllables_enabled : 0) |
+                   (config.enable_components ? format::components_enabled : 0);
+    header.total_words = results.stats.total_words;
+    header.total_characters = results.stats.total_characters;
+    header.total_syllables = results.stats.total_syllables;
+    header.avg_word_length = results.stats.avg_word_length;
+    header.avg_syllables_per_word = results.stats.avg_syllables_per_word;
+
+    OutputFile out(filename);
+    SectionWriter writer(out);
+    writer.write_bytes(&header, sizeof(header));
+    for (const TableData& table : tables_) {
+        writer.write_bytes(&table.record, sizeof(table.record));
+    }
+    writer.write_array(header.string_offsets_offset, string_offsets.data(), string_offsets.size());
+    writer.pad_to(header.string_data_offset);
+    for (const auto& str : strings_) {
+        writer.write_bytes(str.data(), str.size());
+    }
+    for (const TableData& table : tables_) {
+        const format::TableRecord& record = table.record;
+        writer.write_array(record.row_keys_offset, table.row_keys.data(), table.row_keys.size());
+        writer.write_array(record.row_starts_offset, table.row_starts.data(), table.row_starts.size());
+        writer.write_array(record.entry_symbols_offset, table.symbols.data(), table.symbols.size());
+        writer.write_array(record.entry_cumulative_offset, table.cumulative.data(), table.cumulative.size());
+    }
+    writer.pad_to(header.file_size);
+    out.close();
+}
+
+} // namespace
+
+void write_binary_profile(const AnalysisResults& results, const std::string& filename) {
+    ProfileBuilder builder;
+
+    StringPool length_strings;
+    FrequencyMap lengths;
+    for (const auto& [len, count] : results.stats.length_distribution) {
+        add_count(lengths, length_strings, std::to_string(len), count);
+    }
+    builder.add_frequencies("stats.length_distribution", lengths);
+
+    const LetterAnalysis& letters = results.letter_analysis;
+    builder.add_frequencies("letter_analysis.unigrams", letters.unigrams);
+    builder.add_frequencies("letter_analysis.bigrams", letters.bigrams);
+    builder.add_frequencies("letter_analysis.trigrams", letters.trigrams);
+    builder.add_frequencies("letter_analysis.fourgrams", letters.fourgrams);
+    builder.add_positional("letter_analysis.positional_bigrams", letters.positional_bigrams);
+    builder.add_positional("letter_analysis.positional_trigrams", letters.positional_trigrams);
+    builder.add_markov_chains("letter_analysis.markov_chains", letters.markov_chains);
+
+    if (results.config.enable_syllables) {
+        const SyllableAnalysis& syllables = results.syllable_analysis;
+        builder.add_list("syllable_analysis.all_syllables", syllables.all_syllables);
+        builder.add_frequencies("syllable_analysis.syllable_frequencies", syllables.syllable_frequencies);
+        builder.add_positional("syllable_analysis.positional_syllables", syllables.positional_syllables);
+        builder.add_markov_chains("syllable_analysis.syllable_markov", syllables.syllable_markov);
+    }
+
+    if (results.config.enable_components) {
+        const ComponentAnalysis& components = results.component_analysis;
+        builder.add_frequencies("component_analysis.frequencies.onsets", components.frequencies.onsets);
+        builder.add_frequencies("component_analysis.frequencies.nuclei", components.frequencies.nuclei);
+        builder.add_frequencies("component_analysis.frequencies.codas", components.frequencies.codas);
+        builder.add_positional("component_analysis.positional_onsets", components.positional_onsets);
+        builder.add_positional("component_analysis.positional_codas", components.positional_codas);
+    }
+
+    builder.write(results, filename);
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,209 @@
+#include "pruning.hpp"
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace nameanalyzer {
+
+void prune_frequencies(FrequencyMap& freq_map, std::size_t min_count) {
+    std::erase_if(freq_map, [min_count](const auto& entry) { return entry.second < min_count; });
+}
+
+void prune_positional(PositionalFrequencies& pos_freq, std::size_t min_count) {
+    prune_frequencies(pos_freq.start, min_count);
+    prune_frequencies(pos_freq.middle, min_count);
+    prune_frequencies(pos_freq.end, min_count);
+}
+
+// Keep the top_k highest counts of next_map
+static void keep_top_k(FrequencyMap& next_map, std::size_t top_k) {
+    if (next_map.size() <= top_k) {
+        return;
+    }
+    std::vector<FrequencyMap::const_iterator> entries;
+    entries.reserve(next_map.size());
+    for (auto it = next_map.cbegin(); it != next_map.cend(); ++it) {
+        entries.push_back(it);
+    }
+    // The map is in key order and the sort is stable, so ties keep the smaller key
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](auto a, auto b) { return a->second > b->second; });
+
+    FrequencyMap kept;
+    for (std::size_t i = 0; i < top_k; ++i) {
+        kept.insert(next_map.extract(entries[i]));
+    }
+    next_map.swap(kept);
+}
+
+void prune_markov_chain(MarkovChain& chain, std::size_t min_count, std::size_t top_k) {
+    for (auto it = chain.begin(); it != chain.end();) {
+        FrequencyMap& next_map = it->second;
+        prune_frequencies(next_map, min_count);
+        if (top_k > 0) {
+            keep_top_k(next_map, top_k);
+        }
+        it = next_map.empty() ? chain.erase(it) : std::next(it);
+    }
+}
+
+void prune_markov_chains(std::map<int, MarkovChain>& chains, std::size_t min_count, std::size_t top_k) {
+    // Every order stays, even if it ends up empty
+    for (auto& [order, chain] : chains) {
+        prune_markov_chain(chain, min_count, top_k);
+    }
+}
+
+void prune_syllable_analysis(SyllableAnalysis& analysis, std::size_t min_count) {
+    prune_frequencies(analysis.syllable_frequencies, min_count);
+    prune_positional(analysis.positional_syllables, min_count);
+    prune_markov_chains(analysis.syllable_markov, min_count, 0);
+
+    if (analysis.all_syllables.size() == analysis.syllable_frequencies.size()) {
+        return;
+    }
+    StringTable kept;
+    for (const auto& syll : analysis.all_syllables) {
+        if (analysis.syllable_frequencies.contains(syll)) {
+            kept.intern(syll);
+        }
+    }
+    analysis.all_syllables = std::move(kept);
+}
+
+void prune_component_analysis(ComponentAnalysis& analysis, std::size_t min_count) {
+    prune_frequencies(analysis.frequencies.onsets, min_count);
+    prune_frequencies(analysis.frequencies.nuclei, min_count);
+    prune_frequencies(analysis.frequencies.codas, min_count);
+    prune_positional(analysis.positional_onsets, min_count);
+    prune_positional(analysis.positional_codas, min_count);
+}
+
+// Key counts and re-keying, over every map of the results
+
+static std::size_t count_keys(const FrequencyMap& freq_map) {
+    return freq_map.size();
+}
+
+static std::size_t count_keys(const PositionalFrequencies& pos_freq) {
+    return pos_freq.start.size() + pos_freq.middle.size() + pos_freq.end.size();
+}
+
+static std::size_t count_keys(const std::map<int, MarkovChain>& chains) {
+    std::size_t keys = 0;
+    for (const auto& [order, chain] : chains) {
+        keys += chain.size();
+        for (const auto& [context, next_map] : chain) {
+            keys += next_map.size();
+        }
+    }
+    return keys;
+}
+
+// Reuses the map's nodes: each one is taken out, re-keyed and appended
+template <typename Map>
+static void move_keys(Map& map, StringPool& strings) {
+    Map moved;
+    while (!map.empty()) {
+        auto node = map.extract(map.begin());
+        node.key() = strings.intern(node.key());
+        if constexpr (std::is_same_v<Map, MarkovChain>) {
+            move_keys(node.mapped(), strings);
+        }
+        moved.insert(moved.end(), std::move(node));
+    }
+    map.swap(moved);
+}
+
+static void move_keys(PositionalFrequencies& pos_freq, StringPool& strings) {
+    move_keys(pos_freq.start, strings);
+    move_keys(pos_freq.middle, strings);
+    move_keys(pos_freq.end, strings);
+}
+
+static void move_keys(std::map<int, MarkovChain>& chains, StringPool& strings) {
+    for (auto& [order, chain] : chains) {
+        move_keys(chain, strings);
+    }
+}
+
+StringTable move_strings(const StringTable& table, StringPool& strings) {
+    StringTable moved;
+    for (const auto& str : table) {
+        moved.intern(strings.intern(str));
+    }
+    return moved;
+}
+
+bool compact_strings(AnalysisResults& results) {
+    LetterAnalysis& letters = results.letter_analysis;
+    SyllableAnalysis& syllables = results.syllable_analysis;
+    ComponentAnalysis& components = results.component_analysis;
+
+    std::size_t pooled = results.strings->size();
+    for (const auto& strings : results.merged_strings) {
+        pooled += strings->size();
+    }
+    std::size_t keys = count_keys(letters.unigrams) + count_keys(letters.bigrams) +
+                       count_keys(letters.trigrams) + count_keys(letters.fourgrams) +
+                       count_keys(letters.positional_bigrams) + count_keys(letters.positional_trigrams) +
+                       count_keys(letters.markov_chains) + syllables.all_syllables.size() +
+                       count_keys(syllables.syllable_frequencies) + count_keys(syllables.positional_syllables) +
+                       count_keys(syllables.syllable_markov) + count_keys(components.frequencies.onsets) +
+                       count_keys(components.frequencies.nuclei) + count_keys(components.frequencies.codas) +
+                       count_keys(components.positional_onsets) + count_keys(components.positional_codas);
+    if (pooled <= 2 * keys) {
+        return false;
+    }
+
+    auto strings = std::make_shared<StringPool>();
+    move_keys(letters.unigrams, *strings);
+    move_keys(letters.bigrams, *strings);
+    move_keys(letters.trigrams, *strings);
+    move_keys(letters.fourgrams, *strings);
+    move_keys(letters.positional_bigrams, *strings);
+    move_keys(letters.positional_trigrams, *strings);
+    move_keys(letters.markov_chains, *strings);
+    syllables.all_syllables = move_strings(syllables.all_syllables, *strings);
+    move_keys(syllables.syllable_frequencies, *strings);
+    move_keys(syllables.positional_syllables, *strings);
+    move_keys(syllables.syllable_markov, *strings);
+    move_keys(components.frequencies.onsets, *strings);
+    move_keys(components.frequencies.nuclei, *strings);
+    move_keys(components.frequencies.codas, *strings);
+    move_keys(components.positional_onsets, *strings);
+    move_keys(components.positional_codas, *strings);
+    results.strings = std::move(strings);
+    results.merged_strings.clear();
+    return true;
+}
+
+void prune_results(AnalysisResults& results) {
+    const Config& config = results.config;
+    std::size_t min_count = config.min_count;
+    std::size_t top_k = config.top_k_per_context;
+    if (min_count <= 1 && top_k == 0) {
+        return;
+    }
+
+    LetterAnalysis& letters = results.letter_analysis;
+    prune_frequencies(letters.unigrams, min_count);
+    prune_frequencies(letters.bigrams, min_count);
+    prune_frequencies(letters.trigrams, min_count);
+    prune_frequencies(letters.fourgrams, min_count);
+    prune_positional(letters.positional_bigrams, min_count);
+    prune_positional(letters.positional_trigrams, min_count);
+    prune_markov_chains(letters.markov_chains, min_count, top_k);
+
+    if (config.enable_syllables) {
+        prune_syllable_analysis(results.syllable_analysis, min_count);
+        prune_markov_chains(results.syllable_analysis.syllable_markov, 0, top_k);
+    }
+    if (config.enable_components) {
+        prune_component_analysis(results.component_analysis, min_count);
+    }
+    compact_strings(results);
+}
+
+} // namespace nameanalyzer
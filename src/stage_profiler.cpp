@@ -0,0 +1,177 @@
+#include "stage_profiler.hpp"
+#include "json_writer.hpp"
+#include "output_file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace nameanalyzer {
+
+namespace {
+
+// Written once, before any worker thread exists
+bool counting_allocations = false;
+
+std::atomic<std::size_t> total_allocation_count{0};
+std::atomic<std::size_t> total_allocation_bytes{0};
+thread_local AllocationCounts thread_allocation_counts;
+
+} // namespace
+
+void count_allocation(std::size_t size) {
+    if (counting_allocations) {
+        total_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        total_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+        thread_allocation_counts.count++;
+        thread_allocation_counts.bytes += size;
+    }
+}
+
+void enable_allocation_counting() {
+    counting_allocations = true;
+}
+
+AllocationCounts process_allocations() {
+    return {total_allocation_count.load(std::memory_order_relaxed),
+            total_allocation_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationCounts thread_allocations() {
+    return thread_allocation_counts;
+}
+
+double process_cpu_seconds() {
+#if defined(__linux__) || defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& tv) {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+bool reset_peak_rss() {
+#if defined(__linux__)
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    return static_cast<bool>(clear_refs.flush());
+#else
+    return false;
+#endif
+}
+
+std::optional<long> peak_rss_kb() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtol(line.c_str() + 6, nullptr, 10);
+        }
+    }
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<long>(usage.ru_maxrss / 1024);  // bytes on macOS
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return std::nullopt;
+#endif
+}
+
+StageMark StageMark::now() {
+    return {std::chrono::steady_clock::now(), thread_allocations()};
+}
+
+void StageMark::charge(StageTiming& stage) {
+    StageMark present = now();
+    stage.wall_seconds += std::chrono::duration<double>(present.time - time).count();
+    stage.allocations += present.allocations.count - allocations.count;
+    stage.allocated_bytes += present.allocations.bytes - allocations.bytes;
+    *this = present;
+}
+
+void add_stage_timing(StageTiming& stage, const StageTiming& other) {
+    stage.wall_seconds += other.wall_seconds;
+    stage.allocations += other.allocations;
+    stage.allocated_bytes += other.allocated_bytes;
+}
+
+void StageProfiler::begin(std::string_view stage) {
+    auto found = std::find_if(stages_.begin(), stages_.end(),
+                              [stage](const StageTiming& timing) { return timing.stage == stage; });
+    if (found == stages_.end()) {
+        found = stages_.insert(stages_.end(), StageTiming{std::string(stage)});
+    }
+    current_ = static_cast<std::size_t>(found - stages_.begin());
+    reset_peak_rss();
+    stage_start_ = Start{};
+}
+
+void StageProfiler::end() {
+    Start present;
+    StageTiming& stage = stages_[current_];
+    stage.wall_seconds += std::chrono::duration<double>(present.time - stage_start_.time).count();
+    stage.cpu_seconds = stage.cpu_seconds.value_or(0.0) + present.cpu_seconds - stage_start_.cpu_seconds;
+    stage.allocations += present.allocations.count - stage_start_.allocations.count;
+    stage.allocated_bytes += present.allocations.bytes - stage_start_.allocations.bytes;
+    if (auto rss = peak_rss_kb()) {
+        stage.peak_rss_kb = std::max(stage.peak_rss_kb.value_or(0), *rss);
+    }
+}
+
+void StageProfiler::add(const StageTiming& stage) {
+    stages_.push_back(stage);
+}
+
+StageTiming StageProfiler::total() const {
+    Start present;
+    StageTiming total{"total"};
+    total.wall_seconds = std::chrono::duration<double>(present.time - run_start_.time).count();
+    total.cpu_seconds = present.cpu_seconds - run_start_.cpu_seconds;
+    total.allocations = present.allocations.count - run_start_.allocations.count;
+    total.allocated_bytes = present.allocations.bytes - run_start_.allocations.bytes;
+    for (const StageTiming& stage : stages_) {
+        if (stage.peak_rss_kb) {
+            total.peak_rss_kb = std::max(total.peak_rss_kb.value_or(0), *stage.peak_rss_kb);
+        }
+    }
+    return total;
+}
+
+void write_stage_profile(const StageProfiler& profiler, const Config& config, const std::string& filename) {
+    OutputFile out(filename);
+    JsonWriter json(out, true);
+
+    json.begin_object();
+    json.key("input_file");
+    json.value(config.input_file);
+    json.key("threads");
+    json.value(config.threads);
+    json.key("batch_size");
+    json.value(config.batch_size);
+    json.key("total");
+    write_stage_timing(json, profiler.total());
+    json.key("stages");
+    write_stage_timings(json, profiler.stages());
+    json.end_object();
+
+    out.put('\n');
+    out.close();
+}
+
+} // namespace nameanalyzer
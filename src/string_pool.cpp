@@ -0,0 +1,97 @@
+#include "string_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+namespace {
+
+// Blocks start small, since an alphabet's pool holds a few dozen
+// characters, and double up to the largest size
+constexpr std::size_t first_block_size = 256;
+constexpr std::size_t block_size = 64 * 1024;
+
+} // namespace
+
+InternedString StringPool::intern(std::string_view str) {
+    if (str.empty()) {
+        return InternedString();
+    }
+    if (str.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("String too long to intern: " + std::to_string(str.size()) + " bytes");
+    }
+
+    // Sharding keeps analysis threads from queueing on a single lock. The
+    // top bits pick the shard, the low ones the slot within it.
+    std::uint64_t hash = std::hash<std::string_view>{}(str);
+    Shard& shard = shards_[hash >> (64 - shard_bits)];
+
+    bool added = false;
+    std::string_view view;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        view = shard.intern(str, hash, added);
+    }
+    if (added) {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return InternedString(view);
+}
+
+std::string_view StringPool::Shard::intern(std::string_view str, std::uint64_t hash, bool& added) {
+    if ((count + 1) * 4 > slots.size() * 3) {
+        grow();
+    }
+    auto short_hash = static_cast<std::uint32_t>(hash);
+    std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.data == nullptr) {
+            slot = {store(str), static_cast<std::uint32_t>(str.size()), short_hash};
+            ++count;
+            added = true;
+            return {slot.data, slot.size};
+        }
+        if (slot.hash == short_hash && std::string_view(slot.data, slot.size) == str) {
+            return {slot.data, slot.size};
+        }
+    }
+}
+
+void StringPool::Shard::grow() {
+    std::vector<Slot> old = std::move(slots);
+    slots.assign(std::max<std::size_t>(64, 2 * old.size()), Slot{});
+    std::size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.data == nullptr) {
+            continue;
+        }
+        // The stored low bits cover any mask a shard will ever need
+        std::size_t i = slot.hash & mask;
+        while (slots[i].data != nullptr) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+}
+
+const char* StringPool::Shard::store(std::string_view str) {
+    if (str.size() > left) {
+        // Oversized strings get a block of their own
+        last_block = std::clamp(2 * last_block, first_block_size, block_size);
+        std::size_t size = std::max(last_block, str.size());
+        blocks.emplace_back(new char[size]);
+        next = blocks.back().get();
+        left = size;
+    }
+    char* stored = next;
+    std::memcpy(stored, str.data(), str.size());
+    next += str.size();
+    left -= str.size();
+    return stored;
+}
+
+} // namespace nameanalyzer
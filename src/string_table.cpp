@@ -0,0 +1,29 @@
+#include "string_table.hpp"
+
+namespace nameanalyzer {
+
+std::size_t StringTable::intern(InternedString str) {
+    auto [it, added] = index_.emplace(str.view(), strings_.size());
+    if (added) {
+        strings_.push_back(str);
+    }
+    return it->second;
+}
+
+std::size_t StringTable::intern(std::string_view str, StringPool& strings) {
+    auto it = index_.find(str);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    return intern(strings.intern(str));
+}
+
+std::optional<std::size_t> StringTable::find(std::string_view str) const {
+    auto it = index_.find(str);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,201 @@
+#include "syllabifier.hpp"
+#include "word_reader.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <utf8proc.h>
+
+namespace nameanalyzer {
+
+// Entries of a class line, split on spaces and tabs
+static std::vector<std::string> split_entries(std::string_view text) {
+    std::vector<std::string> entries;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t start = text.find_first_not_of(" \t\r", pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        std::size_t end = std::min(text.find_first_of(" \t\r", start), text.size());
+        entries.push_back(to_lowercase(text.substr(start, end - start)));
+        pos = end;
+    }
+    return entries;
+}
+
+PhonemeClasses read_phoneme_file(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Cannot open phoneme file: " + filename);
+    }
+
+    PhonemeClasses classes;
+    classes.vowels.clear();
+    std::string line;
+    for (int line_number = 1; std::getline(in, line); ++line_number) {
+        std::string_view text = line;
+        text = text.substr(0, text.find('#'));
+        if (text.find_first_not_of(" \t\r") == std::string_view::npos) {
+            continue;
+        }
+
+        std::size_t colon = text.find(':');
+        if (colon == std::string_view::npos) {
+            throw std::runtime_error(filename + ":" + std::to_string(line_number) +
+                                     ": expected \"<class>: <entries>\"");
+        }
+        std::string_view name = text.substr(0, colon);
+        name.remove_prefix(std::min(name.find_first_not_of(" \t"), name.size()));
+        name = name.substr(0, name.find_last_not_of(" \t") + 1);
+
+        std::vector<std::string> entries = split_entries(text.substr(colon + 1));
+        std::vector<std::string>* target = nullptr;
+        if (name == "vowels") {
+            target = &classes.vowels;
+        } else if (name == "glides") {
+            target = &classes.glides;
+        } else if (name == "onsets") {
+            target = &classes.onsets;
+        } else {
+            throw std::runtime_error(filename + ":" + std::to_string(line_number) +
+                                     ": unknown phoneme class \"" + std::string(name) + "\"");
+        }
+        target->insert(target->end(), entries.begin(), entries.end());
+    }
+
+    if (classes.vowels.empty()) {
+        throw std::runtime_error("Phoneme file " + filename + " defines no vowels");
+    }
+    return classes;
+}
+
+// The single codepoint of entry, or -1 if it has none or several
+static std::int32_t single_codepoint(const std::string& entry) {
+    utf8proc_int32_t codepoint;
+    utf8proc_ssize_t bytes = utf8proc_iterate(reinterpret_cast<const utf8proc_uint8_t*>(entry.data()),
+                                              static_cast<utf8proc_ssize_t>(entry.size()), &codepoint);
+    return bytes > 0 && static_cast<std::size_t>(bytes) == entry.size() ? codepoint : -1;
+}
+
+Syllabifier::Syllabifier(const PhonemeClasses& classes)
+    : page_index_(codepoint_limit >> 8, 0), pages_(1) {
+    pages_[0].fill(consonant);
+
+    auto add_class = [this](const std::vector<std::string>& entries, Class value, const char* name) {
+        for (const auto& entry : entries) {
+            std::int32_t codepoint = single_codepoint(entry);
+            if (codepoint < 0) {
+                throw std::runtime_error(std::string("Phoneme class ") + name + " entry \"" + entry +
+                                         "\" is not a single character");
+            }
+            if (class_of(codepoint) != consonant && class_of(codepoint) != value) {
+                throw std::runtime_error("\"" + entry + "\" is both a vowel and a glide");
+            }
+            set_class(codepoint, value);
+            set_class(utf8proc_toupper(codepoint), value);
+        }
+    };
+    add_class(classes.vowels, vowel, "vowels");
+    add_class(classes.glides, glide, "glides");
+
+    Utf8Word decoded;
+    for (const auto& onset : classes.onsets) {
+        decode_utf8(onset, decoded);
+        onsets_.intern(onset, onset_strings_);
+        max_onset_length_ = std::max(max_onset_length_, decoded.size());
+    }
+}
+
+void Syllabifier::set_class(std::int32_t codepoint, Class value) {
+    auto cp = static_cast<std::uint32_t>(codepoint);
+    std::uint16_t& page = page_index_[cp >> 8];
+    if (page == 0) {
+        // First entry of this block: give it a page of its own
+        page = static_cast<std::uint16_t>(pages_.size());
+        pages_.push_back(pages_[0]);
+    }
+    pages_[page][cp & 0xFF] = value;
+}
+
+std::size_t Syllabifier::coda_length(const Utf8Word& word, std::size_t first, std::size_t last) const {
+    std::size_t length = last - first;
+    if (length <= 1) {
+        return 0;
+    }
+    if (onsets_.empty()) {
+        return 1;
+    }
+    // Longest permitted onset that ends the cluster; a single consonant
+    // always may
+    std::size_t start = length > max_onset_length_ ? last - max_onset_length_ : first;
+    for (; start + 1 < last; ++start) {
+        if (onsets_.contains(word.slice(start, last))) {
+            break;
+        }
+    }
+    return start - first;
+}
+
+void Syllabifier::split(const Utf8Word& word, std::vector<Syllable>& syllables) const {
+    std::size_t count = 0;
+    auto next_syllable = [&]() -> Syllable& {
+        if (count == syllables.size()) {
+            syllables.emplace_back();
+        }
+        return syllables[count++];
+    };
+
+    std::size_t size = word.size();
+    if (word.text.empty()) {
+        syllables.clear();
+        return;
+    }
+
+    // Classify every codepoint, resolving glides by their neighbours
+    SmallBuffer<std::uint8_t, Utf8Word::inline_size + 1> in_nucleus;
+    in_nucleus.resize(size + 1);
+    Class next_class = class_of(size > 0 ? word.codepoints[0] : -1);
+    for (std::size_t i = 0; i < size; ++i) {
+        Class current = next_class;
+        next_class = i + 1 < size ? class_of(word.codepoints[i + 1]) : consonant;
+        in_nucleus[i] = current == vowel || (current == glide && i > 0 && next_class != vowel);
+    }
+    in_nucleus[size] = 0;  // Sentinel: ends the last nucleus
+
+    // One syllable per nucleus; consonants go to onsets and codas
+    std::size_t cluster_start = 0;  // Consonants since the previous nucleus
+    for (std::size_t i = 0; i < size;) {
+        if (!in_nucleus[i]) {
+            ++i;
+            continue;
+        }
+        std::size_t nucleus_start = i;
+        while (in_nucleus[i]) {
+            ++i;
+        }
+
+        std::size_t onset_start = cluster_start;
+        if (count > 0) {
+            onset_start += coda_length(word, cluster_start, nucleus_start);
+            syllables[count - 1].coda.assign(word.slice(cluster_start, onset_start));
+        }
+        Syllable& syll = next_syllable();
+        syll.onset.assign(word.slice(onset_start, nucleus_start));
+        syll.nucleus.assign(word.slice(nucleus_start, i));
+        syll.coda.clear();
+        cluster_start = i;
+    }
+
+    if (count == 0) {
+        // No vowels: the whole word is one syllable with no nucleus
+        Syllable& syll = next_syllable();
+        syll.onset.assign(word.text);
+        syll.nucleus.clear();
+        syll.coda.clear();
+    } else {
+        syllables[count - 1].coda.assign(word.slice(cluster_start, size));
+    }
+    syllables.resize(count);
+}
+
+} // namespace nameanalyzer
@@ -0,0 +1,67 @@
+#include "utf8_word.hpp"
+#include "case_fold.hpp"
+#include <utf8proc.h>
+#include <limits>
+#include <string>
+#include <stdexcept>
+
+namespace nameanalyzer {
+
+void decode_utf8(std::string_view text, Utf8Word& word) {
+    if (text.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Word too long to decode: " + std::to_string(text.size()) + " bytes");
+    }
+    word.text = text;
+    auto length = static_cast<std::uint32_t>(text.size());
+
+    if (is_ascii(text)) {
+        // One codepoint per byte
+        word.codepoints.resize(length);
+        word.byte_positions.resize(length + 1);
+        for (std::uint32_t i = 0; i < length; ++i) {
+            word.codepoints[i] = static_cast<unsigned char>(text[i]);
+            word.byte_positions[i] = i;
+        }
+        word.byte_positions[length] = length;
+        return;
+    }
+
+    word.codepoints.clear();
+    word.byte_positions.clear();
+    word.byte_positions.push_back(0);  // First codepoint starts at byte 0
+
+    std::uint32_t byte_pos = 0;
+    bool after_invalid = false;
+    while (byte_pos < length) {
+        auto byte = static_cast<unsigned char>(text[byte_pos]);
+        if (byte < 0x80) {
+            // ASCII inside mixed text needs no decoding either
+            byte_pos++;
+            word.codepoints.push_back(after_invalid ? -1 : byte);
+            word.byte_positions.push_back(byte_pos);
+            after_invalid = false;
+            continue;
+        }
+
+        utf8proc_int32_t codepoint;
+        utf8proc_ssize_t bytes_read = utf8proc_iterate(
+            reinterpret_cast<const utf8proc_uint8_t*>(text.data() + byte_pos),
+            static_cast<utf8proc_ssize_t>(length - byte_pos),
+            &codepoint
+        );
+
+        if (bytes_read <= 0) {
+            // Invalid UTF-8 - skip this byte
+            byte_pos++;
+            after_invalid = true;
+            continue;
+        }
+
+        byte_pos += static_cast<std::uint32_t>(bytes_read);
+        word.codepoints.push_back(after_invalid ? -1 : codepoint);
+        word.byte_positions.push_back(byte_pos);
+        after_invalid = false;
+    }
+}
+
+} // namespace nameanalyzer
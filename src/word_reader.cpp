@@ -1,70 +1,356 @@
 #include <algorithm>
-#include <cctype>
-#include <fstream>
+#include <charconv>
 #include <iostream>
-#include <sstream>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
-#include <utf8proc.h>
+#include <thread>
 #include "word_reader.hpp"
 
 namespace nameanalyzer {
 
 std::string to_lowercase(std::string_view str) {
-    // Use utf8proc for proper Unicode case folding
-    utf8proc_uint8_t* result = nullptr;
-    utf8proc_ssize_t result_size = utf8proc_map(
-        reinterpret_cast<const utf8proc_uint8_t*>(str.data()),
-        static_cast<utf8proc_ssize_t>(str.size()),
-        &result,
-        static_cast<utf8proc_option_t>(UTF8PROC_NULLTERM | UTF8PROC_STABLE | UTF8PROC_COMPOSE | UTF8PROC_CASEFOLD)
-    );
+    // Proper Unicode case folding via utf8proc, with an ASCII fast path
+    std::string output;
+    CaseFolder().fold(str, output);
+    return output;
+}
 
-    if (result_size < 0 || !result) {
-        throw std::runtime_error("UTF-8 case conversion failed for: " + std::string(str));
+// Same set std::istream's operator>> splits on
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Case-fold token, returning token itself when folding leaves it unchanged
+// and the folded text (stored in scratch) otherwise
+static std::string_view fold_case(std::string_view token, CaseFolder& folder, std::string& scratch) {
+    if (is_ascii(token)) {
+        bool has_upper = false;
+        for (char c : token) {
+            has_upper |= static_cast<unsigned char>(c - 'A') < 26;
+        }
+        if (!has_upper) {
+            return token;
+        }
     }
 
-    std::string output(reinterpret_cast<const char*>(result), static_cast<size_t>(result_size));
-    free(result);  // utf8proc uses malloc
-    return output;
+    folder.fold(token, scratch);
+    return scratch == token ? token : std::string_view(scratch);
 }
 
-std::vector<std::string> read_words(std::string_view filename, int min_length) {
-    std::ifstream file(filename.data());
-    if (!file) {
-        throw std::runtime_error("Failed to open file: " + std::string(filename));
+WordFilter::Verdict WordFilter::filter(std::string_view token, std::string_view& word) {
+    static const std::string_view blacklist_chars = "(),.!@$%^&*-_=+[{]}/?<>";
+
+    word = fold_case(token, folder_, folded_);
+
+    // ensure minimum length
+    if (static_cast<int>(word.length()) < min_length_) {
+        return Verdict::TooShort;
     }
 
-    std::vector<std::string> words;
-    std::string line;
-    std::string blacklist_chars = "(),.!@$%^&*-_=+[{]}/?<>";
+    // ensure no bad characters
+    if (word.find_first_of(blacklist_chars) != std::string_view::npos) {
+        return Verdict::BadCharacters;
+    }
+    return Verdict::Accepted;
+}
 
-    while (std::getline(file, line)) {
+namespace {
 
-	// Remove any comments
-	auto comment_pos = line.find('#');
-	if (comment_pos != std::string::npos) {
-	    line.erase(comment_pos);
-	}
+// Bytes each thread parses per block, enough to outweigh starting threads
+constexpr std::size_t range_bytes = std::size_t{1} << 20;
 
-	// split by whitespace
-	std::istringstream iss(to_lowercase(line));
-	std::string word;
-	while (iss >> word) {
+// A problem with one line, located by the reader that owns the line
+struct LineError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
 
-	    // ensure minimum length
-	    if (static_cast<int>(word.length()) < min_length) {
-		continue;
-	    }
+// The count of a weighted line, after its word
+std::size_t parse_weight(std::string_view fields) {
+    while (!fields.empty() && is_space(fields.front())) {
+        fields.remove_prefix(1);
+    }
+    while (!fields.empty() && is_space(fields.back())) {
+        fields.remove_suffix(1);
+    }
 
-	    // ensure no bad characters
-	    if (word.find_first_of(blacklist_chars) != std::string::npos) {
-		std::cout << "Skipping " << word << "\n";
-		continue;
-	    }
+    std::size_t weight = 0;
+    auto result = std::from_chars(fields.data(), fields.data() + fields.size(), weight);
+    if (fields.empty()) {
+        throw LineError("missing count after the word");
+    }
+    if (result.ec != std::errc() || result.ptr != fields.data() + fields.size()) {
+        throw LineError("invalid count \"" + std::string(fields) + "\"");
+    }
+    return weight;
+}
+
+// Offset just past the newline that ends the line containing pos
+std::size_t line_end_after(std::string_view text, std::size_t pos) {
+    if (pos == 0 || pos >= text.size()) {
+        return std::min(pos, text.size());
+    }
+    std::size_t newline = text.find('\n', pos - 1);
+    return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+} // namespace
+
+void WordReader::Scanner::reset(std::string_view text) {
+    text_ = text;
+    next_line_ = 0;
+    line_ = {};
+    lines_ = 0;
+}
+
+bool WordReader::Scanner::next(std::string_view& word, std::size_t& weight, std::string& skipped) {
+    while (true) {
+        // Skip whitespace; move on to the next line when this one is used up
+        while (!line_.empty() && is_space(line_.front())) {
+            line_.remove_prefix(1);
+        }
+
+        if (line_.empty()) {
+            if (next_line_ >= text_.size()) {
+                return false;
+            }
+
+            std::size_t line_end = text_.find('\n', next_line_);
+            if (line_end == std::string_view::npos) {
+                line_end = text_.size();
+            }
+            line_ = text_.substr(next_line_, line_end - next_line_);
+            next_line_ = line_end + 1;
+            ++lines_;
+
+            // Remove any comments (case folding also stops at a NUL byte)
+            line_ = line_.substr(0, line_.find('#'));
+            line_ = line_.substr(0, line_.find('\0'));
+            continue;
+        }
+
+        std::size_t token_end = 0;
+        while (token_end < line_.size() && !is_space(line_[token_end])) {
+            ++token_end;
+        }
+        std::string_view token;
+        WordFilter::Verdict verdict = filter_.filter(line_.substr(0, token_end), token);
+        line_.remove_prefix(token_end);
+        weight = 1;
+        if (weighted_) {
+            // The rest of the line is the count
+            weight = parse_weight(line_);
+            line_ = {};
+            if (weight == 0) {
+                continue;
+            }
+        }
+
+        if (verdict == WordFilter::Verdict::BadCharacters) {
+            skipped += "Skipping ";
+            skipped += token;
+            skipped += '\n';
+        }
+        if (verdict != WordFilter::Verdict::Accepted) {
+            continue;
+        }
+
+        word = token;
+        return true;
+    }
+}
+
+WordReader::WordReader(std::string_view filename, int min_length, bool weighted, int threads)
+    : filename_(filename), file_(filename_), scanner_(min_length, weighted) {
+    scanner_.reset(file_.contents());
+    // A file that fits in one range gains nothing from more threads
+    std::size_t useful = file_.contents().size() / range_bytes + 1;
+    std::size_t num_threads = std::min(static_cast<std::size_t>(std::max(threads, 1)), useful);
+    if (num_threads > 1) {
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            parts_.emplace_back(Scanner(min_length, weighted));
+        }
+    }
+}
+
+void WordReader::report_skipped(std::string& skipped) {
+    if (!skipped.empty()) {
+        std::cout << skipped;
+        skipped.clear();
+    }
+}
 
-	    words.push_back(std::move(word));
-	}
+void WordReader::rethrow_at(std::size_t line) const {
+    try {
+        throw;
+    } catch (const LineError& error) {
+        throw std::runtime_error(filename_ + ":" + std::to_string(line) + ": " + error.what());
     }
+}
+
+bool WordReader::parse_block() {
+    std::string_view contents = file_.contents();
+    if (next_block_ >= contents.size()) {
+        return false;
+    }
+
+    // Cut the block into one range per thread, each ending at a newline
+    std::size_t num_threads = parts_.size();
+    std::size_t block_size = std::min(num_threads * range_bytes, contents.size() - next_block_);
+    std::vector<std::size_t> bounds(num_threads + 1);
+    for (std::size_t i = 0; i <= num_threads; ++i) {
+        bounds[i] = line_end_after(contents, next_block_ + block_size * i / num_threads);
+    }
+    bounds.front() = next_block_;
+    next_block_ = bounds.back();
+
+    auto parse_range = [&](std::size_t i) {
+        Part& part = parts_[i];
+        part.scanner.reset(contents.substr(bounds[i], bounds[i + 1] - bounds[i]));
+        part.count = 0;
+        part.weights.clear();
+        part.skipped.clear();
+        part.failure = nullptr;
+        try {
+            // Overwrite the previous block's strings to reuse their storage
+            std::string_view word;
+            std::size_t weight;
+            while (part.scanner.next(word, weight, part.skipped)) {
+                if (part.count < part.words.size()) {
+                    part.words[part.count].assign(word);
+                } else {
+                    part.words.emplace_back(word);
+                }
+                part.weights.push_back(weight);
+                ++part.count;
+            }
+        } catch (...) {
+            part.failure = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        workers.emplace_back(parse_range, i);
+    }
+    parse_range(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Report in file order: a range's messages, then its error if any
+    for (Part& part : parts_) {
+        report_skipped(part.skipped);
+        if (part.failure) {
+            try {
+                std::rethrow_exception(part.failure);
+            } catch (...) {
+                rethrow_at(lines_before_ + part.scanner.lines());
+            }
+        }
+        lines_before_ += part.scanner.lines();
+    }
+    part_ = 0;
+    index_ = 0;
+    return true;
+}
+
+bool WordReader::next_word(std::string_view& word) {
+    std::size_t weight;
+    return next_word(word, weight);
+}
+
+bool WordReader::next_word(std::string_view& word, std::size_t& weight) {
+    if (parts_.empty()) {
+        bool found = false;
+        try {
+            found = scanner_.next(word, weight, skipped_);
+        } catch (...) {
+            report_skipped(skipped_);
+            rethrow_at(scanner_.lines());
+        }
+        report_skipped(skipped_);
+        if (!found) {
+            return false;
+        }
+    } else {
+        while (part_ == parts_.size() || index_ == parts_[part_].count) {
+            if (part_ < parts_.size()) {
+                ++part_;
+                index_ = 0;
+            } else if (!parse_block()) {
+                return false;
+            }
+        }
+        word = parts_[part_].words[index_];
+        weight = parts_[part_].weights[index_];
+        ++index_;
+    }
+
+    ++words_read_;
+    occurrences_read_ += weight;
+    return true;
+}
+
+bool WordReader::next_batch(std::vector<std::string>& batch, std::vector<std::size_t>& weights,
+                            std::size_t max_words) {
+    return next_batch(batch, &weights, max_words);
+}
+
+bool WordReader::next_batch(std::vector<std::string>& batch, std::size_t max_words) {
+    return next_batch(batch, nullptr, max_words);
+}
+
+bool WordReader::next_batch(std::vector<std::string>& batch, std::vector<std::size_t>* weights,
+                            std::size_t max_words) {
+    // Overwrite the previous batch's strings in place to reuse their storage
+    std::size_t count = 0;
+    std::string_view word;
+    std::size_t weight;
+    if (weights) {
+        weights->clear();
+    }
+    while (count < max_words && next_word(word, weight)) {
+        if (count < batch.size()) {
+            batch[count].assign(word);
+        } else {
+            batch.emplace_back(word);
+        }
+        if (weights) {
+            weights->push_back(weight);
+        }
+        ++count;
+    }
+
+    batch.resize(count);
+    return count > 0;
+}
+
+void WordTally::add(std::string_view word, std::size_t weight) {
+    auto it = index_.find(word);
+    if (it != index_.end()) {
+        weights_[it->second] += weight;
+        return;
+    }
+    // Key the index on the tally's own copy of the word
+    const std::string& stored = words_.emplace_back(word);
+    index_.emplace(stored, words_.size() - 1);
+    weights_.push_back(weight);
+}
+
+void WordTally::take(std::vector<std::string>& words, std::vector<std::size_t>& weights) {
+    index_.clear();
+    words.assign(std::make_move_iterator(words_.begin()), std::make_move_iterator(words_.end()));
+    words_.clear();
+    weights = std::move(weights_);
+    weights_.clear();
+}
+
+std::vector<std::string> read_words(std::string_view filename, int min_length) {
+    WordReader reader(filename, min_length);
+
+    std::vector<std::string> words;
+    reader.next_batch(words, std::numeric_limits<std::size_t>::max());
 
     if (words.empty()) {
         throw std::runtime_error("No valid words found in file");
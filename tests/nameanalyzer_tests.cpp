@@ -0,0 +1,714 @@
+// Regression tests for the analysis library.
+// Each test is a function that reports failed checks with their line; the
+// executable runs them all and exits with 1 if any check failed, so CTest
+// can run it as a single test.
+
+#include "analyzer.hpp"
+#include "alias_table.hpp"
+#include "analysis_merge.hpp"
+#include "json_reader.hpp"
+#include "json_writer.hpp"
+#include "profile_index.hpp"
+#include "profile_reader.hpp"
+#include "profile_server.hpp"
+#include "profile_writer.hpp"
+#include "syllabifier.hpp"
+#include "types.hpp"
+#include "utf8_word.hpp"
+#include "word_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+using namespace nameanalyzer;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+            ++failures;                                                                    \
+        }                                                                                  \
+    } while (false)
+
+const std::vector<std::string> first_words = {
+    "Persephone", "Athena",    "Apollo",   "Artemis",  "Hermes",    "Hephaestus", "Dionysus",
+    "Demeter",    "Poseidon",  "Hestia",   "Aphrodite", "Ares",     "Hera",       "Zeus",
+    "Asclepius",  "Eileithyia", "Nemesis", "Hecate",   "Helios",    "Selene",     "Eos",
+};
+
+const std::vector<std::string> more_words = {
+    "Odin",   "Thor",     "Freya",  "Frigg",   "Baldur",  "Loki",    "Heimdall", "Tyr",
+    "Njord",  "Freyr",    "Skadi",  "Idunn",   "Bragi",   "Sif",     "Ullr",     "Vidar",
+    "Athena", "Poseidon", "Apollo", "Artemis", "Persephone",
+};
+
+// A path in the temporary directory that no other run uses
+std::filesystem::path temp_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() /
+           ("nameanalyzer_tests_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+            "_" + name);
+}
+
+// Deterministic made-up names, built from a few hundred syllables with a
+// skewed choice so that some are common and many are rare
+std::vector<std::string> synthetic_words(std::size_t count) {
+    static const std::vector<std::string> onsets = {"", "b", "d", "k", "l", "m", "n", "r", "s", "t",
+                                                    "th", "st", "dr", "gw", "ph", "x", "z", "qu"};
+    static const std::vector<std::string> nuclei = {"a", "e", "i", "o", "u", "ae", "io", "y"};
+    static const std::vector<std::string> codas = {"", "", "", "n", "s", "r", "l", "x", "nd", "rth"};
+    std::uint64_t state = 12345;
+    auto next = [&state](std::size_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Squaring a uniform draw favours the first entries
+        double draw = static_cast<double>(state >> 11) / static_cast<double>(std::uint64_t{1} << 53);
+        return static_cast<std::size_t>(draw * draw * static_cast<double>(bound));
+    };
+    std::vector<std::string> words;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string word;
+        std::size_t syllables = 1 + next(4);
+        for (std::size_t j = 0; j < syllables; ++j) {
+            word += onsets[next(onsets.size())] + nuclei[next(nuclei.size())] + codas[next(codas.size())];
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Analyzing everything at once and continuing a profile of order 5 with
+// approximate counting must agree on every Markov order above 3, which
+// cannot be sketched and are counted exactly
+void test_update_high_order_approximate() {
+    for (int threads : {1, 2}) {
+        Config config;
+        config.markov_order = 5;
+        Analyzer first(config);
+        first.add(first_words);
+        AnalysisResults profile = first.finish();
+
+        Config approximate;
+        approximate.approximate_epsilon = 0.01;
+        approximate.threads = threads;
+        approximate.batch_size = 8;
+        Analyzer updated(profile, approximate);
+        updated.add(more_words);
+        AnalysisResults results = updated.finish();
+
+        Analyzer exact(config);
+        exact.add(first_words);
+        exact.add(more_words);
+        AnalysisResults expected = exact.finish();
+
+        const auto& chains = results.letter_analysis.markov_chains;
+        CHECK(chains.size() == 5);
+        CHECK(results.config.markov_order == 5);
+        for (int order = 4; order <= 5; ++order) {
+            CHECK(chains.at(order) == expected.letter_analysis.markov_chains.at(order));
+        }
+        const MarkovChain& top = chains.at(5);
+        CHECK(top.contains(std::string_view("^^^^^")));
+        for (const auto& [context, next] : top) {
+            CHECK(context.size() == 5);
+        }
+    }
+}
+
+// Continuing a pruned, approximate profile with default settings must not
+// label the results exact and unpruned
+void test_continue_keeps_profile_pruning() {
+    Config config;
+    config.input_file = "first.txt";
+    config.markov_order = 2;
+    config.min_count = 2;
+    config.top_k_per_context = 5;
+    config.approximate_epsilon = 0.01;
+    config.sampling_tables = true;
+    Analyzer first(config);
+    first.add(first_words);
+    AnalysisResults profile = first.finish();
+
+    Analyzer continued(profile, Config{});
+    continued.add(more_words);
+    AnalysisResults results = continued.finish();
+    CHECK(results.config.markov_order == 2);
+    CHECK(results.config.min_count == 2);
+    CHECK(results.config.top_k_per_context == 5);
+    CHECK(results.config.approximate_epsilon == 0.01);
+    CHECK(results.config.sampling_tables);
+    CHECK(results.config.input_file == "first.txt");
+
+    // Stronger settings of the caller win, as with --update
+    Config stronger;
+    stronger.input_file = "more.txt";
+    stronger.min_count = 3;
+    stronger.top_k_per_context = 10;
+    Config merged = continued_config(profile.config, stronger);
+    CHECK(merged.min_count == 3);
+    CHECK(merged.top_k_per_context == 5);
+    CHECK(merged.input_file == "first.txt,more.txt");
+}
+
+// A sketch for a tiny epsilon would not fit in memory; the settings are
+// rejected up front instead
+void test_rejects_tiny_epsilon() {
+    Config config;
+    config.approximate_epsilon = 1e-9;
+    bool rejected = false;
+    try {
+        Analyzer analyzer(config);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+// One sampling table as written to the JSON
+struct WrittenTable {
+    std::vector<std::string> symbols;
+    std::vector<double> probabilities;
+    std::vector<double> thresholds;
+    std::vector<std::size_t> aliases;
+};
+
+WrittenTable read_sampling_table(JsonReader& json) {
+    WrittenTable table;
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        json.begin_array();
+        while (json.next_element()) {
+            if (key == "symbols") {
+                table.symbols.push_back(json.read_string());
+            } else if (key == "probabilities") {
+                table.probabilities.push_back(json.read_double());
+            } else if (key == "alias_thresholds") {
+                table.thresholds.push_back(json.read_double());
+            } else {
+                table.aliases.push_back(json.read_size());
+            }
+        }
+    }
+    return table;
+}
+
+// The written table must read back as exactly the AliasTable built from
+// the same counts, so that a generator loading it samples the same way
+void check_table(const WrittenTable& written, const FrequencyMap& counts) {
+    std::vector<std::size_t> weights;
+    std::vector<std::string> symbols;
+    for (const auto& [symbol, count] : counts) {
+        symbols.emplace_back(symbol);
+        weights.push_back(count);
+    }
+    AliasTable table(weights);
+    CHECK(written.symbols == symbols);
+    CHECK(written.probabilities == table.probabilities());
+    CHECK(written.thresholds == table.thresholds());
+    CHECK(written.aliases == std::vector<std::size_t>(table.aliases().begin(), table.aliases().end()));
+
+    double sum = 0.0;
+    for (double probability : written.probabilities) {
+        sum += probability;
+    }
+    CHECK(std::abs(sum - 1.0) < 1e-12);
+}
+
+void test_sampling_tables_round_trip() {
+    Config config;
+    config.sampling_tables = true;
+    Analyzer analyzer(config);
+    analyzer.add(first_words);
+    analyzer.add(more_words);
+    AnalysisResults results = analyzer.finish();
+
+    auto path = temp_path("profile.json");
+    write_json_output(results, path.string());
+    std::string text;
+    {
+        std::ifstream in(path, std::ios::binary);
+        text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::filesystem::remove(path);
+
+    JsonReader json(text);
+    std::size_t tables = 0;
+    std::string key;
+    json.begin_object();
+    while (json.next_member(key)) {
+        if (key != "sampling") {
+            json.skip_value();
+            continue;
+        }
+        json.begin_object();
+        while (json.next_member(key)) {
+            if (key != "letter_markov") {
+                json.skip_value();
+                continue;
+            }
+            std::string order;
+            json.begin_object();
+            while (json.next_member(order)) {
+                const MarkovChain& chain = results.letter_analysis.markov_chains.at(std::stoi(order.substr(6)));
+                std::string context;
+                json.begin_object();
+                while (json.next_member(context)) {
+                    check_table(read_sampling_table(json), chain.find(std::string_view(context))->second);
+                    ++tables;
+                }
+            }
+        }
+    }
+    CHECK(tables > 0);
+}
+
+std::vector<std::string> read_all_words(const std::string& path, int threads) {
+    WordReader reader(path, 2, false, threads);
+    std::vector<std::string> words;
+    std::vector<std::string> batch;
+    while (reader.next_batch(batch, 7)) {
+        words.insert(words.end(), batch.begin(), batch.end());
+    }
+    return words;
+}
+
+// Every kept count of lossy may be too high by at most bound, never too
+// low, and every entry counted more than bound times must be kept
+void check_lossy(const FrequencyMap& exact, const FrequencyMap& lossy, std::size_t bound) {
+    for (const auto& [key, count] : lossy) {
+        auto it = exact.find(key);
+        std::size_t actual = it == exact.end() ? 0 : it->second;
+        CHECK(count >= actual && count <= actual + bound);
+    }
+    for (const auto& [key, count] : exact) {
+        CHECK(count <= bound || lossy.contains(key));
+    }
+}
+
+void check_lossy(const PositionalFrequencies& exact, const PositionalFrequencies& lossy, std::size_t bound) {
+    check_lossy(exact.start, lossy.start, bound);
+    check_lossy(exact.middle, lossy.middle, bound);
+    check_lossy(exact.end, lossy.end, bound);
+}
+
+void check_lossy(const std::map<int, MarkovChain>& exact, const std::map<int, MarkovChain>& lossy,
+                 std::size_t bound) {
+    static const FrequencyMap none;
+    for (const auto& [order, chain] : exact) {
+        const MarkovChain& pruned = lossy.at(order);
+        for (const auto& [context, next] : chain) {
+            auto it = pruned.find(context);
+            check_lossy(next, it == pruned.end() ? none : it->second, bound);
+        }
+        for (const auto& [context, next] : pruned) {
+            CHECK(chain.contains(context));
+        }
+    }
+}
+
+// Lossy counting bounds every map, syllables and components included, and
+// does not depend on the thread count
+void test_lossy_pruning_bounds() {
+    std::vector<std::string> words = synthetic_words(20000);
+    Config config;
+    Analyzer exact(config);
+    exact.add(words);
+    AnalysisResults expected = exact.finish();
+
+    Config lossy_config;
+    lossy_config.prune_epsilon = 0.001;
+    lossy_config.batch_size = 1000;
+    AnalysisResults single;
+    for (int threads : {1, 2}) {
+        lossy_config.threads = threads;
+        Analyzer lossy(lossy_config);
+        lossy.add(words);
+        AnalysisResults results = lossy.finish();
+        std::size_t bound = results.stats.prune_error_bound;
+        CHECK(bound > 0);
+        CHECK(bound <= static_cast<std::size_t>(lossy_config.prune_epsilon *
+                                                static_cast<double>(results.stats.total_words)));
+
+        const LetterAnalysis& letters = results.letter_analysis;
+        check_lossy(expected.letter_analysis.bigrams, letters.bigrams, bound);
+        check_lossy(expected.letter_analysis.trigrams, letters.trigrams, bound);
+        check_lossy(expected.letter_analysis.fourgrams, letters.fourgrams, bound);
+        check_lossy(expected.letter_analysis.positional_bigrams, letters.positional_bigrams, bound);
+        check_lossy(expected.letter_analysis.positional_trigrams, letters.positional_trigrams, bound);
+        check_lossy(expected.letter_analysis.markov_chains, letters.markov_chains, bound);
+
+        const SyllableAnalysis& syllables = results.syllable_analysis;
+        check_lossy(expected.syllable_analysis.syllable_frequencies, syllables.syllable_frequencies, bound);
+        check_lossy(expected.syllable_analysis.positional_syllables, syllables.positional_syllables, bound);
+        check_lossy(expected.syllable_analysis.syllable_markov, syllables.syllable_markov, bound);
+        CHECK(syllables.syllable_frequencies.size() < expected.syllable_analysis.syllable_frequencies.size());
+        CHECK(syllables.all_syllables.size() == syllables.syllable_frequencies.size());
+        for (const auto& syllable : syllables.all_syllables) {
+            CHECK(syllables.syllable_frequencies.contains(syllable));
+        }
+
+        const ComponentAnalysis& components = results.component_analysis;
+        check_lossy(expected.component_analysis.frequencies.onsets, components.frequencies.onsets, bound);
+        check_lossy(expected.component_analysis.frequencies.nuclei, components.frequencies.nuclei, bound);
+        check_lossy(expected.component_analysis.frequencies.codas, components.frequencies.codas, bound);
+        check_lossy(expected.component_analysis.positional_onsets, components.positional_onsets, bound);
+        check_lossy(expected.component_analysis.positional_codas, components.positional_codas, bound);
+
+        if (threads == 1) {
+            single = std::move(results);
+        } else {
+            CHECK(results.syllable_analysis.syllable_frequencies == single.syllable_analysis.syllable_frequencies);
+            CHECK(results.component_analysis.frequencies.onsets == single.component_analysis.frequencies.onsets);
+            CHECK(results.letter_analysis.markov_chains == single.letter_analysis.markov_chains);
+        }
+    }
+}
+
+#if !defined(_WIN32)
+// Pipes report a size of 0 and cannot be mapped, so they are read to their
+// end instead; they must give the same words as a regular file
+void test_reads_words_from_pipe() {
+    std::string text;
+    for (const std::string& word : first_words) {
+        text += word + "\n";
+    }
+    text += "x\n";  // Too short, dropped
+    auto file = temp_path("words.txt");
+    std::ofstream(file, std::ios::binary) << text;
+    std::vector<std::string> expected = read_all_words(file.string(), 1);
+    std::filesystem::remove(file);
+    CHECK(expected.size() == first_words.size());
+
+    // A reader that stops early must fail the checks, not kill the tests
+    std::signal(SIGPIPE, SIG_IGN);
+    for (int threads : {1, 2}) {
+        auto fifo = temp_path("words.fifo");
+        CHECK(::mkfifo(fifo.c_str(), 0600) == 0);
+        std::thread writer([&] { std::ofstream(fifo, std::ios::binary) << text; });
+        std::vector<std::string> words = read_all_words(fifo.string(), threads);
+        writer.join();
+        std::filesystem::remove(fifo);
+        CHECK(words == expected);
+    }
+}
+#endif
+
+void check_same(const PositionalFrequencies& a, const PositionalFrequencies& b) {
+    CHECK(a.start == b.start);
+    CHECK(a.middle == b.middle);
+    CHECK(a.end == b.end);
+}
+
+// Every count of a and b must agree; their configs may differ
+void check_same_counts(const AnalysisResults& a, const AnalysisResults& b) {
+    CHECK(a.stats.total_words == b.stats.total_words);
+    CHECK(a.stats.total_characters == b.stats.total_characters);
+    CHECK(a.stats.total_syllables == b.stats.total_syllables);
+    CHECK(a.stats.length_distribution == b.stats.length_distribution);
+
+    const LetterAnalysis& letters = a.letter_analysis;
+    CHECK(letters.unigrams == b.letter_analysis.unigrams);
+    CHECK(letters.bigrams == b.letter_analysis.bigrams);
+    CHECK(letters.trigrams == b.letter_analysis.trigrams);
+    CHECK(letters.fourgrams == b.letter_analysis.fourgrams);
+    check_same(letters.positional_bigrams, b.letter_analysis.positional_bigrams);
+    check_same(letters.positional_trigrams, b.letter_analysis.positional_trigrams);
+    CHECK(letters.markov_chains == b.letter_analysis.markov_chains);
+
+    const SyllableAnalysis& syllables = a.syllable_analysis;
+    CHECK(std::equal(syllables.all_syllables.begin(), syllables.all_syllables.end(),
+                     b.syllable_analysis.all_syllables.begin(), b.syllable_analysis.all_syllables.end()));
+    CHECK(syllables.syllable_frequencies == b.syllable_analysis.syllable_frequencies);
+    check_same(syllables.positional_syllables, b.syllable_analysis.positional_syllables);
+    CHECK(syllables.syllable_markov == b.syllable_analysis.syllable_markov);
+
+    const ComponentAnalysis& components = a.component_analysis;
+    CHECK(components.frequencies.onsets == b.component_analysis.frequencies.onsets);
+    CHECK(components.frequencies.nuclei == b.component_analysis.frequencies.nuclei);
+    CHECK(components.frequencies.codas == b.component_analysis.frequencies.codas);
+    check_same(components.positional_onsets, b.component_analysis.positional_onsets);
+    check_same(components.positional_codas, b.component_analysis.positional_codas);
+}
+
+AnalysisResults analyze(const std::vector<std::vector<std::string>>& corpora) {
+    Analyzer analyzer;
+    for (const auto& words : corpora) {
+        analyzer.add(words);
+    }
+    return analyzer.finish();
+}
+
+// Merging the profiles of two halves, and continuing the profile of the
+// first half after a JSON round trip, must both give the profile of the
+// whole corpus
+void test_merge_and_update_match_single_run() {
+    AnalysisResults expected = analyze({first_words, more_words});
+
+    AnalysisResults merged = analyze({first_words});
+    merge_results(merged, analyze({more_words}));
+    check_same_counts(merged, expected);
+
+    auto path = temp_path("first.json");
+    write_json_output(analyze({first_words}), path.string());
+    AnalysisResults profile = read_json_profile(path.string());
+    std::filesystem::remove(path);
+    check_same_counts(profile, analyze({first_words}));
+
+    Analyzer updated(profile, Config{});
+    updated.add(more_words);
+    check_same_counts(updated.finish(), expected);
+}
+
+// A binary profile row must hold exactly the entries of counts
+void check_row(const std::optional<ProfileRow>& row, const FrequencyMap& counts) {
+    CHECK(row.has_value());
+    if (!row) {
+        return;
+    }
+    CHECK(row->size() == counts.size());
+    std::size_t i = 0;
+    for (const auto& [key, count] : counts) {
+        if (i < row->size()) {
+            CHECK(row->symbol(i) == key);
+            CHECK(row->count(i) == count);
+        }
+        ++i;
+    }
+}
+
+void test_binary_profile_round_trip() {
+    AnalysisResults results = analyze({first_words, more_words});
+    auto path = temp_path("profile.bin");
+    write_binary_profile(results, path.string());
+    {
+        ProfileReader profile(path.string());
+        auto bigrams = profile.find_table("letter_analysis.bigrams");
+        CHECK(bigrams.has_value());
+        if (bigrams) {
+            check_row(bigrams->frequencies(), results.letter_analysis.bigrams);
+        }
+        auto syllables = profile.find_table("syllable_analysis.syllable_frequencies");
+        CHECK(syllables.has_value());
+        if (syllables) {
+            check_row(syllables->frequencies(), results.syllable_analysis.syllable_frequencies);
+        }
+        auto ends = profile.find_table("component_analysis.positional_codas.end");
+        CHECK(ends.has_value());
+        if (ends) {
+            check_row(ends->frequencies(), results.component_analysis.positional_codas.end);
+        }
+        for (const auto& [order, chain] : results.letter_analysis.markov_chains) {
+            auto table = profile.find_table("letter_analysis.markov_chains.order_" + std::to_string(order));
+            CHECK(table.has_value());
+            if (!table) {
+                continue;
+            }
+            CHECK(table->order() == static_cast<std::uint32_t>(order));
+            CHECK(table->row_count() == chain.size());
+            for (const auto& [context, next] : chain) {
+                check_row(table->find(context), next);
+            }
+        }
+        CHECK(!profile.find_table("letter_analysis.markov_chains.order_9"));
+    }
+    std::filesystem::remove(path);
+}
+
+// A weighted word list, and the distinct words of a corpus with their
+// counts, must give the profile of the repeated words
+void test_weighted_and_dedupe_match_repeats() {
+    std::vector<std::string> repeated;
+    std::string text;
+    for (std::size_t i = 0; i < first_words.size(); ++i) {
+        std::size_t count = i % 4;  // Including 0, which the reader skips
+        for (std::size_t j = 0; j < count; ++j) {
+            repeated.push_back(first_words[i]);
+        }
+        text += first_words[i] + "\t" + std::to_string(count) + "\n";
+    }
+    AnalysisResults expected = analyze({repeated});
+
+    auto file = temp_path("weighted.txt");
+    std::ofstream(file, std::ios::binary) << text;
+    for (int threads : {1, 2}) {
+        WordReader reader(file.string(), 2, true, threads);
+        Analyzer analyzer;
+        std::vector<std::string> batch;
+        std::vector<std::size_t> weights;
+        while (reader.next_batch(batch, weights, 5)) {
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                analyzer.add(batch[i], weights[i]);
+            }
+        }
+        CHECK(reader.occurrences_read() == repeated.size());
+        check_same_counts(analyzer.finish(), expected);
+    }
+    std::filesystem::remove(file);
+
+    WordTally tally;
+    for (const std::string& word : repeated) {
+        tally.add(word);
+    }
+    std::vector<std::string> words;
+    std::vector<std::size_t> weights;
+    tally.take(words, weights);
+    CHECK(words.size() < repeated.size());
+    CHECK(tally.size() == 0);
+    Analyzer analyzer;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        analyzer.add(words[i], weights[i]);
+    }
+    check_same_counts(analyzer.finish(), expected);
+}
+
+std::string query(const ProfileIndex& index, std::string_view request) {
+    static const LatencyHistogram latency;
+    std::string out;
+    answer_query(index, latency, request, out);
+    return out;
+}
+
+void test_serve_protocol() {
+    AnalysisResults results = analyze({first_words, more_words});
+    ProfileIndex index(results);
+    const FrequencyMap& bigrams = results.letter_analysis.bigrams;
+
+    std::size_t total = 0;
+    std::size_t above = 0;  // Bigrams counted more often than "he"
+    std::size_t he = bigrams.find(std::string_view("he"))->second;
+    for (const auto& [key, count] : bigrams) {
+        total += count;
+        above += count > he ? 1 : 0;
+    }
+    std::string count = query(index, "count bigrams he");
+    std::string prefix = "ok " + std::to_string(he) + " " + std::to_string(total) + " ";
+    CHECK(count.starts_with(prefix) && count.ends_with("\n"));
+    // Ties rank in key order, so "he" ranks after every more frequent bigram
+    CHECK(std::stoul(count.substr(prefix.size())) > above);
+    CHECK(query(index, "count bigrams zzz") == "ok 0 " + std::to_string(total) + " 0\n");
+
+    // What follows "^" is the first letter of every word
+    const FrequencyMap& starts = results.letter_analysis.markov_chains.at(1).find(std::string_view("^"))->second;
+    std::string next = query(index, "next ^ 1");
+    std::size_t words = results.stats.total_words;
+    CHECK(next.starts_with("ok " + std::to_string(words) + " "));
+    std::size_t most = 0;
+    for (const auto& [letter, n] : starts) {
+        most = std::max(most, n);
+    }
+    CHECK(next.ends_with(" " + std::to_string(most) + "\n"));
+    CHECK(query(index, "next qqq") == "ok 0\n");
+
+    CHECK(query(index, "stats") == "ok words " + std::to_string(words) + " characters " +
+                                       std::to_string(results.stats.total_characters) + " syllables " +
+                                       std::to_string(results.stats.total_syllables) + "\n");
+    CHECK(query(index, "top nosuchtable").starts_with("err "));
+    CHECK(query(index, "next ^ many").starts_with("err "));
+    CHECK(query(index, "count bigrams").starts_with("err "));
+    CHECK(query(index, "").starts_with("err "));
+    CHECK(query(index, "frobnicate").starts_with("err "));
+}
+
+std::vector<std::string> split(const Syllabifier& syllabifier, std::string_view text) {
+    Utf8Word word;
+    decode_utf8(text, word);
+    std::vector<Syllable> syllables;
+    syllabifier.split(word, syllables);
+    std::vector<std::string> parts;
+    for (const Syllable& syllable : syllables) {
+        parts.push_back(syllable.to_string());
+    }
+    return parts;
+}
+
+void test_phoneme_file_syllabification() {
+    auto file = temp_path("phonemes.txt");
+    std::ofstream(file, std::ios::binary) << "# Test classes\n"
+                                             "vowels: a e i O u  # uppercase entries are folded\n"
+                                             "\n"
+                                             "glides: y\n"
+                                             "onsets: st tr\n";
+    PhonemeClasses classes = read_phoneme_file(file.string());
+    CHECK(classes.vowels == std::vector<std::string>({"a", "e", "i", "o", "u"}));
+    CHECK(classes.glides == std::vector<std::string>({"y"}));
+    CHECK(classes.onsets == std::vector<std::string>({"st", "tr"}));
+
+    Syllabifier syllabifier(classes);
+    // A glide before a vowel is a consonant, elsewhere a vowel
+    CHECK(split(syllabifier, "maya") == std::vector<std::string>({"ma", "ya"}));
+    CHECK(split(syllabifier, "day") == std::vector<std::string>({"day"}));
+    CHECK(split(syllabifier, "yara") == std::vector<std::string>({"ya", "ra"}));
+    // Onsets take the longest permitted cluster, the rest closes the coda
+    CHECK(split(syllabifier, "astra") == std::vector<std::string>({"as", "tra"}));
+    CHECK(split(syllabifier, "arlo") == std::vector<std::string>({"ar", "lo"}));
+    CHECK(split(syllabifier, "brr") == std::vector<std::string>({"brr"}));
+
+    std::ofstream(file, std::ios::binary) << "vowels: a\nconsonants: b\n";
+    bool rejected = false;
+    try {
+        read_phoneme_file(file.string());
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    std::filesystem::remove(file);
+}
+
+struct Test {
+    const char* name;
+    std::function<void()> run;
+};
+
+const std::vector<Test> tests = {
+    {"update_high_order_approximate", test_update_high_order_approximate},
+    {"rejects_tiny_epsilon", test_rejects_tiny_epsilon},
+    {"continue_keeps_profile_pruning", test_continue_keeps_profile_pruning},
+    {"sampling_tables_round_trip", test_sampling_tables_round_trip},
+    {"lossy_pruning_bounds", test_lossy_pruning_bounds},
+    {"merge_and_update_match_single_run", test_merge_and_update_match_single_run},
+    {"binary_profile_round_trip", test_binary_profile_round_trip},
+    {"weighted_and_dedupe_match_repeats", test_weighted_and_dedupe_match_repeats},
+    {"serve_protocol", test_serve_protocol},
+    {"phoneme_file_syllabification", test_phoneme_file_syllabification},
+#if !defined(_WIN32)
+    {"reads_words_from_pipe", test_reads_words_from_pipe},
+#endif
+};
+
+} // namespace
+
+int main() {
+    for (const Test& test : tests) {
+        int before = failures;
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            std::cerr << test.name << ": unexpected exception: " << e.what() << "\n";
+            ++failures;
+        }
+        std::cout << (failures == before ? "PASS " : "FAIL ") << test.name << "\n";
+    }
+    return failures == 0 ? 0 : 1;
+}